@@ -0,0 +1,606 @@
+#include "FramBench.h"
+
+// Large enough for bulk transfers, small enough to be a static on the Electron
+static uint8_t benchBuf[1024];
+static uint8_t checkBuf[128];
+
+/**
+ * @brief Passes reads and writes through to another MB85RC until the power is cut, after writesLeft writes
+ *
+ * Every write after that fails without reaching the FRAM, as if the device had reset in the middle of
+ * whatever operation was running.
+ */
+class PowerCutFram : public MB85RC {
+public:
+	PowerCutFram(MB85RC &target, TwoWire &wire, size_t writesLeft) :
+		MB85RC(wire, target.length()), target(target), writesLeft(writesLeft) {};
+
+	virtual bool readData(size_t framAddr, uint8_t *data, size_t dataLen) {
+		return target.readData(framAddr, data, dataLen);
+	}
+
+	virtual bool writeData(size_t framAddr, const uint8_t *data, size_t dataLen) {
+		if (writesLeft == 0) {
+			return false;
+		}
+		writesLeft--;
+		return target.writeData(framAddr, data, dataLen);
+	}
+
+protected:
+	MB85RC &target;
+	size_t writesLeft;
+};
+
+TimeTest::TimeTest(const char *name, TwoWire &wire, size_t ops, size_t bytes) : wire(wire), ops(ops), bytes(bytes) {
+	strncpy(this->name, name, sizeof(this->name) - 1);
+	this->name[sizeof(this->name) - 1] = 0;
+#ifdef PARTICLE_HOST_SIM
+	startStats = wire.stats();
+#endif
+	start = micros();
+}
+
+TimeTest::~TimeTest() {
+	unsigned long elapsed = micros() - start;
+
+	unsigned long bytesPerSec = 0;
+	if (bytes && elapsed) {
+		bytesPerSec = (unsigned long)((uint64_t)bytes * 1000000 / elapsed);
+	}
+
+#ifdef PARTICLE_HOST_SIM
+	const BusStats &stats = wire.stats();
+	unsigned long transactions = stats.transactions - startStats.transactions;
+	unsigned long busMicros = (unsigned long)(stats.busMicros - startStats.busMicros);
+	unsigned long perOp100 = ops ? (transactions * 100 / ops) : 0;
+
+	Log.info("%s: %u ops, %u bytes in %lu us, %lu bytes/sec, %lu.%02lu transactions/op, bus time %lu us",
+		name, ops, bytes, elapsed, bytesPerSec, perOp100 / 100, perOp100 % 100, busMicros);
+#else
+	Log.info("%s: %u ops, %u bytes in %lu us, %lu bytes/sec", name, ops, bytes, elapsed, bytesPerSec);
+#endif
+}
+
+
+FramBench::FramBench(MB85RC &fram, TwoWire &wire, const char *deviceName) :
+	fram(fram), wire(wire), deviceName(deviceName) {
+}
+
+bool FramBench::run() {
+	if (!verify()) {
+		return false;
+	}
+	return benchmark();
+}
+
+bool FramBench::verify() {
+	return verifySimple() && verifyBoundary() && verifyMove() && verifyFill() && verifyCache() && verifyVectored() && verifyLayout() && verifyRing() && verifyErase();
+}
+
+bool FramBench::benchmark() {
+	size_t bulkIterations = fram.length() / sizeof(benchBuf);
+
+	return benchRead(4, 100) &&
+		benchRead(128, 100) &&
+		benchRead(sizeof(benchBuf), bulkIterations) &&
+		benchWrite(4, 100) &&
+		benchWrite(128, 100) &&
+		benchWrite(sizeof(benchBuf), bulkIterations) &&
+		benchMove(128, 10) &&
+		benchMove(sizeof(benchBuf), 10) &&
+		benchErase() &&
+		benchEraseBackground() &&
+		benchCache() &&
+		benchVectored();
+}
+
+bool FramBench::checkPattern(size_t framAddr, const uint8_t *expected, size_t len, int line) {
+	while(len > 0) {
+		size_t count = len;
+		if (count > sizeof(checkBuf)) {
+			count = sizeof(checkBuf);
+		}
+		if (!fram.readData(framAddr, checkBuf, count)) {
+			Log.error("%s: readData failed framAddr=%u count=%u line=%u", deviceName, framAddr, count, line);
+			return false;
+		}
+		for(size_t ii = 0; ii < count; ii++) {
+			uint8_t want = expected ? expected[ii] : 0;
+			if (checkBuf[ii] != want) {
+				Log.error("%s: data was %02x expected %02x framAddr=%u line=%u", deviceName, checkBuf[ii], want, framAddr + ii, line);
+				return false;
+			}
+		}
+		if (expected) {
+			expected += count;
+		}
+		framAddr += count;
+		len -= count;
+	}
+	return true;
+}
+
+bool FramBench::verifySimple() {
+	uint32_t d1;
+	bool bResult = fram.readData(0, (uint8_t *)&d1, sizeof(d1));
+	if (!bResult) {
+		Log.info("%s: readData failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	d1++;
+	bResult = fram.writeData(0, (const uint8_t *)&d1, sizeof(d1));
+	if (!bResult) {
+		Log.info("%s: writeData failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	return checkPattern(0, (const uint8_t *)&d1, sizeof(d1), __LINE__);
+}
+
+bool FramBench::verifyBoundary() {
+	// Only the MB85RC1M has the special 64K bank boundary
+	if (fram.length() <= 65536) {
+		return true;
+	}
+
+	uint8_t buf1[128];
+
+	for(size_t testNum = 0; testNum < 100; testNum++) {
+		for(size_t ii = 0; ii < sizeof(buf1); ii++) {
+			buf1[ii] = (uint8_t) rand();
+		}
+
+		size_t framAddr = 65535 - rand() % 120;
+
+		bool bResult = fram.writeData(framAddr, buf1, sizeof(buf1));
+		if (!bResult) {
+			Log.info("%s: writeData failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+
+		if (!checkPattern(framAddr, buf1, sizeof(buf1), __LINE__)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FramBench::verifyMove() {
+	uint8_t buf1[128];
+	uint8_t expected[128];
+
+	for(size_t ii = 0; ii < sizeof(buf1); ii++) {
+		buf1[ii] = (uint8_t) rand();
+	}
+
+	// Move higher
+	if (!fram.writeData(0, buf1, sizeof(buf1)) || !fram.moveData(50, 75, 40)) {
+		Log.info("%s: write/move failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	memcpy(expected, buf1, sizeof(expected));
+	memcpy(&expected[75], &buf1[50], 40);
+	if (!checkPattern(0, expected, sizeof(expected), __LINE__)) {
+		return false;
+	}
+
+	// Move lower
+	if (!fram.writeData(0, buf1, sizeof(buf1)) || !fram.moveData(50, 25, 40)) {
+		Log.info("%s: write/move failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	memcpy(expected, buf1, sizeof(expected));
+	memcpy(&expected[25], &buf1[50], 40);
+	return checkPattern(0, expected, sizeof(expected), __LINE__);
+}
+
+bool FramBench::verifyErase() {
+	if (!fram.erase()) {
+		Log.info("%s: erase failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	return checkPattern(0, NULL, fram.length(), __LINE__);
+}
+
+bool FramBench::verifyFill() {
+	uint8_t expected[128];
+
+	// Fill the middle of a known pattern and make sure the edges are untouched
+	for(size_t ii = 0; ii < sizeof(expected); ii++) {
+		expected[ii] = (uint8_t) rand();
+	}
+	if (!fram.writeData(0, expected, sizeof(expected)) || !fram.fill(10, 0xa5, 100)) {
+		Log.info("%s: write/fill failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	memset(&expected[10], 0xa5, 100);
+	if (!checkPattern(0, expected, sizeof(expected), __LINE__)) {
+		return false;
+	}
+
+	// Background erase of the same range
+	if (!fram.startErase(10, 100)) {
+		Log.info("%s: startErase failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	while(fram.isFillBusy()) {
+		if (!fram.fillProcess(16)) {
+			Log.info("%s: fillProcess failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+	}
+	memset(&expected[10], 0, 100);
+	return checkPattern(0, expected, sizeof(expected), __LINE__);
+}
+
+bool FramBench::verifyCache() {
+	uint8_t expected[64];
+	for(size_t ii = 0; ii < sizeof(expected); ii++) {
+		expected[ii] = (uint8_t) rand();
+	}
+	if (!fram.writeData(0, expected, sizeof(expected))) {
+		Log.info("%s: writeData failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	// Cache 16..47, on-demand so nothing is written until flush()
+	MB85RCCacheStatic<32> cache(fram, 16, MB85RCCache::ON_DEMAND);
+	uint32_t value = 0x12345678;
+	if (!cache.begin() || !cache.put(20, value) || !cache.writeData(30, expected, 16)) {
+		Log.info("%s: cache write failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	uint32_t check;
+	if (cache.get(20, check) != value || !checkPattern(0, expected, sizeof(expected), __LINE__)) {
+		Log.info("%s: cache read or FRAM changed before flush line=%u", deviceName, __LINE__);
+		return false;
+	}
+	if (!cache.flush()) {
+		Log.info("%s: flush failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	memcpy(&expected[20], &value, sizeof(value));
+	memmove(&expected[30], expected, 16);
+	if (!checkPattern(0, expected, sizeof(expected), __LINE__)) {
+		return false;
+	}
+
+	// More separate changes than there are dirty ranges, flushed together
+	uint8_t before[64];
+	memcpy(before, expected, sizeof(before));
+	cache.setFlushPolicy(MB85RCCache::WRITE_THROUGH);
+	cache.beginUpdate();
+	for(size_t ii = 16; ii < 48; ii += 3) {
+		uint8_t b = (uint8_t) rand();
+		cache.put(ii, b);
+		expected[ii] = b;
+	}
+	if (!checkPattern(0, before, sizeof(before), __LINE__) || !cache.endUpdate() || cache.isDirty()) {
+		Log.info("%s: endUpdate failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	return checkPattern(0, expected, sizeof(expected), __LINE__);
+}
+
+bool FramBench::verifyVectored() {
+	uint8_t expected[64];
+	for(size_t ii = 0; ii < sizeof(expected); ii++) {
+		expected[ii] = (uint8_t) rand();
+	}
+
+	// Two adjacent segments, a gap, then a third
+	uint8_t a[5], b[11], c[7];
+	memcpy(a, &expected[0], sizeof(a));
+	memcpy(b, &expected[5], sizeof(b));
+	memcpy(c, &expected[40], sizeof(c));
+	MB85RCSegment writeSegs[] = { {0, a, sizeof(a)}, {5, b, sizeof(b)}, {40, c, sizeof(c)} };
+	if (!fram.writeData(0, expected, sizeof(expected)) || !fram.fill(0, 0, 16) || !fram.fill(40, 0, 7) || !fram.writev(writeSegs, 3)) {
+		Log.info("%s: writev failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	if (!checkPattern(0, expected, sizeof(expected), __LINE__)) {
+		return false;
+	}
+
+	memset(a, 0, sizeof(a));
+	memset(b, 0, sizeof(b));
+	memset(c, 0, sizeof(c));
+	MB85RCSegment readSegs[] = { {0, a, sizeof(a)}, {5, b, sizeof(b)}, {40, c, sizeof(c)} };
+	if (!fram.readv(readSegs, 3)) {
+		Log.info("%s: readv failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	if (memcmp(a, &expected[0], sizeof(a)) || memcmp(b, &expected[5], sizeof(b)) || memcmp(c, &expected[40], sizeof(c))) {
+		Log.error("%s: readv data mismatch line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	// Trailing empty segments, one of them at an unrelated address. The last real run still has to end
+	// with a STOP, which the host TwoWire checks when the lock is released.
+	memset(a, 0, sizeof(a));
+	memset(c, 0, sizeof(c));
+	MB85RCSegment trailingSegs[] = { {0, a, sizeof(a)}, {40, c, sizeof(c)}, {47, b, 0}, {100, b, 0} };
+	if (!fram.readv(trailingSegs, 4)) {
+		Log.info("%s: readv failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	if (memcmp(a, &expected[0], sizeof(a)) || memcmp(c, &expected[40], sizeof(c))) {
+		Log.error("%s: readv data mismatch line=%u", deviceName, __LINE__);
+		return false;
+	}
+	return true;
+}
+
+namespace BenchMap {
+	typedef MB85RCField<0x00, uint8_t> Flags;
+	typedef MB85RCFieldAfter<Flags, int16_t, 2> Offset;
+	typedef MB85RCFieldAfter<Offset, uint32_t, 4> Counter;
+	typedef MB85RCField<0x10, double> Reading;
+	typedef MB85RCLayout<8192, Flags, Offset, Counter, Reading> Layout;
+	typedef MB85RCGroup<Flags, Offset, Counter, Reading> All;
+
+	static_assert(Offset::addr == 0x02 && Counter::addr == 0x04 && Layout::end == 0x18, "BenchMap layout");
+};
+
+bool FramBench::verifyLayout() {
+	if (!fram.put<BenchMap::Flags>(0x5a) || !fram.put<BenchMap::Counter>(123456789) || fram.get<BenchMap::Flags>() != 0x5a) {
+		Log.info("%s: typed put/get failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	if (!BenchMap::All::store(fram, 0xa5, -42, 987654321, 3.25)) {
+		Log.info("%s: group store failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	uint8_t flags;
+	int16_t offset;
+	uint32_t counter;
+	double reading;
+	if (!BenchMap::All::load(fram, flags, offset, counter, reading) ||
+		flags != 0xa5 || offset != -42 || counter != 987654321 || reading != 3.25 ||
+		fram.get<BenchMap::Counter>() != 987654321) {
+		Log.error("%s: group load mismatch line=%u", deviceName, __LINE__);
+		return false;
+	}
+	return true;
+}
+
+bool FramBench::verifyRing() {
+	typedef MB85RCRing<uint32_t, 5> Ring;
+
+	if (!fram.erase(0x100, sizeof(Ring::Storage))) {
+		Log.info("%s: erase failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	{
+		Ring ring(fram, 0x100);
+		if (!ring.begin() || !ring.empty()) {
+			Log.info("%s: ring begin failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+		// Push 7 into a ring of 5 so the two oldest are dropped, then pop one
+		for(uint32_t ii = 1; ii <= 7; ii++) {
+			ring.push(ii);
+		}
+		ring.pop();
+	}
+
+	// Another instance, as after a reset, sees 4..7
+	Ring ring(fram, 0x100);
+	uint32_t value;
+	if (!ring.begin() || ring.size() != 4) {
+		Log.info("%s: ring not restored size=%u line=%u", deviceName, ring.size(), __LINE__);
+		return false;
+	}
+	for(uint32_t ii = 4; ii <= 7; ii++) {
+		if (!ring.peek(value) || value != ii || !ring.pop()) {
+			Log.error("%s: ring order wrong line=%u", deviceName, __LINE__);
+			return false;
+		}
+	}
+
+	// Tear the newer header slot as a power loss during the commit of 9 would; 8 must remain
+	ring.push(8);
+	ring.push(9);
+	Ring::Header slots[2];
+	fram.readData(0x100, (uint8_t *)slots, sizeof(slots));
+	size_t newer = ((int32_t)(slots[0].commit - slots[1].commit) > 0) ? 0 : 1;
+	slots[newer].count ^= 0x5a;
+	fram.writeData(0x100 + newer * sizeof(Ring::Header), (const uint8_t *)&slots[newer], sizeof(Ring::Header));
+
+	Ring restored(fram, 0x100);
+	if (!restored.begin() || restored.size() != 1 || !restored.peek(value) || value != 8) {
+		Log.error("%s: torn header not recovered size=%u line=%u", deviceName, restored.size(), __LINE__);
+		return false;
+	}
+
+	// Cut the power after each write of a push of 6 to a full ring of 1..5, including between the record
+	// write and the header write. Whatever is left must be an unbroken run ending at 5 or 6.
+	for(size_t cut = 0; cut <= 3; cut++) {
+		fram.erase(0x100, sizeof(Ring::Storage));
+		Ring full(fram, 0x100);
+		full.begin();
+		for(uint32_t ii = 1; ii <= 5; ii++) {
+			full.push(ii);
+		}
+
+		PowerCutFram cutFram(fram, wire, cut);
+		Ring cutRing(cutFram, 0x100);
+		cutRing.begin();
+		cutRing.push(6);
+
+		Ring after(fram, 0x100);
+		uint32_t last = 0;
+		if (!after.begin() || after.empty() || !after.peek(last, after.size() - 1) || (last != 5 && last != 6)) {
+			Log.error("%s: ring lost after power cut %u size=%u line=%u", deviceName, cut, after.size(), __LINE__);
+			return false;
+		}
+		for(size_t ii = 0; ii < after.size(); ii++) {
+			if (!after.peek(value, ii) || value != last - (after.size() - 1) + ii) {
+				Log.error("%s: ring torn by power cut %u at %u line=%u", deviceName, cut, ii, __LINE__);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool FramBench::benchRead(size_t len, size_t iterations) {
+	char name[48];
+	snprintf(name, sizeof(name), "%s readData %u", deviceName, (unsigned) len);
+
+	size_t framAddr = 0;
+	TimeTest timer(name, wire, iterations, len * iterations);
+	for(size_t ii = 0; ii < iterations; ii++) {
+		if (!fram.readData(framAddr, benchBuf, len)) {
+			Log.info("%s: readData failed framAddr=%u line=%u", deviceName, framAddr, __LINE__);
+			return false;
+		}
+		framAddr = (framAddr + len) % fram.length();
+	}
+	return true;
+}
+
+bool FramBench::benchWrite(size_t len, size_t iterations) {
+	char name[48];
+	snprintf(name, sizeof(name), "%s writeData %u", deviceName, (unsigned) len);
+
+	for(size_t ii = 0; ii < len; ii++) {
+		benchBuf[ii] = (uint8_t) rand();
+	}
+
+	size_t framAddr = 0;
+	TimeTest timer(name, wire, iterations, len * iterations);
+	for(size_t ii = 0; ii < iterations; ii++) {
+		if (!fram.writeData(framAddr, benchBuf, len)) {
+			Log.info("%s: writeData failed framAddr=%u line=%u", deviceName, framAddr, __LINE__);
+			return false;
+		}
+		framAddr = (framAddr + len) % fram.length();
+	}
+	return true;
+}
+
+bool FramBench::benchMove(size_t len, size_t iterations) {
+	char name[48];
+	snprintf(name, sizeof(name), "%s moveData %u", deviceName, (unsigned) len);
+
+	// Alternate overlapping moves up and down by half the length
+	TimeTest timer(name, wire, iterations, len * iterations);
+	for(size_t ii = 0; ii < iterations; ii++) {
+		size_t from = (ii & 1) ? len / 2 : 0;
+		size_t to = (ii & 1) ? 0 : len / 2;
+		if (!fram.moveData(from, to, len)) {
+			Log.info("%s: moveData failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FramBench::benchErase() {
+	char name[48];
+	snprintf(name, sizeof(name), "%s erase", deviceName);
+
+	TimeTest timer(name, wire, 1, fram.length());
+	if (!fram.erase()) {
+		Log.info("%s: erase failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+	return true;
+}
+
+bool FramBench::benchEraseBackground() {
+	char name[48];
+	snprintf(name, sizeof(name), "%s erase slice", deviceName);
+
+	if (!fram.startErase()) {
+		Log.info("%s: startErase failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	// Each fillProcess() call is what one pass through loop() would cost
+	unsigned long maxSlice = 0;
+	size_t slices = 0;
+	unsigned long start = micros();
+	while(fram.isFillBusy()) {
+		unsigned long sliceStart = micros();
+		if (!fram.fillProcess()) {
+			Log.info("%s: fillProcess failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+		unsigned long sliceTime = micros() - sliceStart;
+		if (sliceTime > maxSlice) {
+			maxSlice = sliceTime;
+		}
+		slices++;
+	}
+	Log.info("%s: %u slices in %lu us, longest slice %lu us", name, slices, micros() - start, maxSlice);
+	return true;
+}
+
+bool FramBench::benchCache() {
+	char name[48];
+	MB85RCCacheStatic<0x2c> cache(fram, 0);
+	if (!cache.begin()) {
+		Log.info("%s: cache begin failed line=%u", deviceName, __LINE__);
+		return false;
+	}
+
+	// The firmware's pattern: read a control byte every sample, rarely change it
+	snprintf(name, sizeof(name), "%s cached get/put 1", deviceName);
+	{
+		TimeTest timer(name, wire, 100, 100);
+		uint8_t controlRegister;
+		for(size_t ii = 0; ii < 100; ii++) {
+			cache.get(4, controlRegister);
+			if ((ii % 25) == 0) {
+				controlRegister ^= 0x02;
+			}
+			cache.put(4, controlRegister);
+		}
+	}
+	return true;
+}
+
+bool FramBench::benchVectored() {
+	char name[48];
+
+	// The firmware's boot-time restore: seven fields from the configuration region
+	uint32_t version, controlRegister, timeZone, resetCount, lockout, pumpingMins, pumpingStart;
+	MB85RCSegment segs[] = {
+		{0x00, &version, 4}, {0x04, &controlRegister, 4}, {0x08, &timeZone, 4}, {0x0C, &resetCount, 4},
+		{0x10, &lockout, 4}, {0x20, &pumpingMins, 4}, {0x24, &pumpingStart, 4}
+	};
+	const size_t numSegs = sizeof(segs) / sizeof(segs[0]);
+
+	snprintf(name, sizeof(name), "%s readData x%u", deviceName, (unsigned) numSegs);
+	{
+		TimeTest timer(name, wire, 1, numSegs * 4);
+		for(size_t ii = 0; ii < numSegs; ii++) {
+			fram.readData(segs[ii].framAddr, (uint8_t *)segs[ii].data, segs[ii].dataLen);
+		}
+	}
+
+	snprintf(name, sizeof(name), "%s readv x%u", deviceName, (unsigned) numSegs);
+	{
+		TimeTest timer(name, wire, 1, numSegs * 4);
+		if (!fram.readv(segs, numSegs)) {
+			Log.info("%s: readv failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+	}
+
+	snprintf(name, sizeof(name), "%s writev x%u", deviceName, (unsigned) numSegs);
+	{
+		TimeTest timer(name, wire, 1, numSegs * 4);
+		if (!fram.writev(segs, numSegs)) {
+			Log.info("%s: writev failed line=%u", deviceName, __LINE__);
+			return false;
+		}
+	}
+	return true;
+}
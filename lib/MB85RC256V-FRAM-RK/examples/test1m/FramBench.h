@@ -0,0 +1,86 @@
+#ifndef __FRAMBENCH_H
+#define __FRAMBENCH_H
+
+#include "Particle.h"
+#include "MB85RC256V-FRAM-RK.h"
+#include "MB85RCCache.h"
+#include "MB85RCLayout.h"
+#include "MB85RCRing.h"
+
+/**
+ * @brief Times a block of code and logs the result when it goes out of scope
+ *
+ * On the device the time is wall-clock time from micros(). On the host simulator (host/Particle.h)
+ * the clock is driven by the modeled I2C bus time, and the bus transaction counters are also reported.
+ */
+class TimeTest {
+public:
+	/**
+	 * @param name Name of the test, included in the log. Copied and truncated to 47 characters.
+	 *
+	 * @param wire The bus the FRAM is on, used for transaction counts on the host
+	 *
+	 * @param ops The number of driver calls made by the test, used to compute per-op figures
+	 *
+	 * @param bytes The number of FRAM bytes processed by the test, used to compute bytes/sec. 0 to omit.
+	 */
+	TimeTest(const char *name, TwoWire &wire, size_t ops = 1, size_t bytes = 0);
+	~TimeTest();
+
+protected:
+	char name[48];
+	TwoWire &wire;
+	size_t ops;
+	size_t bytes;
+	unsigned long start;
+#ifdef PARTICLE_HOST_SIM
+	BusStats startStats;
+#endif
+};
+
+/**
+ * @brief Benchmark and verification suite for the MB85RC driver
+ *
+ * Runs correctness checks, then measures readData, writeData, moveData and erase throughput on one
+ * device. The contents of the FRAM are destroyed.
+ */
+class FramBench {
+public:
+	FramBench(MB85RC &fram, TwoWire &wire, const char *deviceName);
+
+	/**
+	 * @brief Run the verification tests, then the benchmarks
+	 *
+	 * Returns false if any verification failed.
+	 */
+	bool run();
+
+	bool verify();
+	bool benchmark();
+
+protected:
+	bool verifySimple();
+	bool verifyBoundary();
+	bool verifyMove();
+	bool verifyErase();
+	bool verifyFill();
+	bool verifyCache();
+	bool verifyVectored();
+	bool verifyLayout();
+	bool verifyRing();
+	bool checkPattern(size_t framAddr, const uint8_t *expected, size_t len, int line);
+
+	bool benchRead(size_t len, size_t iterations);
+	bool benchWrite(size_t len, size_t iterations);
+	bool benchMove(size_t len, size_t iterations);
+	bool benchErase();
+	bool benchEraseBackground();
+	bool benchCache();
+	bool benchVectored();
+
+	MB85RC &fram;
+	TwoWire &wire;
+	const char *deviceName;
+};
+
+#endif /* __FRAMBENCH_H */
@@ -0,0 +1,63 @@
+#include "FramSim.h"
+
+#include <string.h>
+
+FramSim::FramSim(size_t memorySize, int addr) : memorySize(memorySize), addr(addr) {
+	if (memorySize > 65536) {
+		// A0 is NC on the MB85RC1M, the low address bit selects the bank
+		this->addr &= 6;
+	}
+	mem = new uint8_t[memorySize];
+	memset(mem, 0xff, memorySize);
+}
+
+FramSim::~FramSim() {
+	delete[] mem;
+}
+
+bool FramSim::matches(uint8_t i2cAddr) const {
+	if ((i2cAddr & 0b1111000) != DEVICE_ADDR) {
+		return false;
+	}
+	if (memorySize > 65536) {
+		return (i2cAddr & 6) == addr;
+	}
+	return (i2cAddr & 7) == addr;
+}
+
+size_t FramSim::bankOf(uint8_t i2cAddr) const {
+	return (memorySize > 65536 && (i2cAddr & 1)) ? 65536 : 0;
+}
+
+void FramSim::advance() {
+	// The address counter rolls over within the 16 bit memory address word (and within the
+	// bank on the MB85RC1M), then is masked to the size of the part
+	size_t bank = latch & ~(size_t)0xffff;
+	latch = bank | ((latch + 1) & 0xffff);
+	latch &= memorySize - 1;
+}
+
+void FramSim::onWrite(uint8_t i2cAddr, const uint8_t *data, size_t dataLen) {
+	if (dataLen < 2) {
+		// Address byte only (or partial memory address): no change to the array
+		return;
+	}
+
+	latch = (bankOf(i2cAddr) | ((size_t)data[0] << 8) | data[1]) & (memorySize - 1);
+
+	for(size_t ii = 2; ii < dataLen; ii++) {
+		mem[latch] = data[ii];
+		advance();
+	}
+}
+
+void FramSim::onRead(uint8_t i2cAddr, uint8_t *data, size_t dataLen) {
+	// Current address read: continues from the latch left by the last read or write. On the MB85RC1M
+	// the bank comes from the device address of this transaction.
+	latch = (bankOf(i2cAddr) | (latch & 0xffff)) & (memorySize - 1);
+
+	for(size_t ii = 0; ii < dataLen; ii++) {
+		data[ii] = mem[latch];
+		advance();
+	}
+}
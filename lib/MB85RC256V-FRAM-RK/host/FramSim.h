@@ -0,0 +1,51 @@
+#ifndef __FRAMSIM_H
+#define __FRAMSIM_H
+
+// In-memory model of an MB85RC family FRAM for the host TwoWire bus. Not used on-device.
+
+#include "HostWire.h"
+
+class FramSim : public I2CDevice {
+public:
+	/**
+	 * @brief Simulated MB85RC FRAM chip
+	 *
+	 * @param memorySize Size of the part in bytes: 8192 (MB85RC64), 32768 (MB85RC256V), 65536 (MB85RC512)
+	 * or 131072 (MB85RC1M)
+	 *
+	 * @param addr The address 0-7 set on the A0, A1 and A2 pins. On the MB85RC1M A0 is NC and the
+	 * low bit of the I2C address selects the 64K bank instead, the same as MB85RC1M::getI2CAddr().
+	 *
+	 * Memory powers up filled with 0xff so reads of never-written locations are obvious.
+	 */
+	FramSim(size_t memorySize, int addr = 0);
+	virtual ~FramSim();
+
+	virtual bool matches(uint8_t i2cAddr) const;
+	virtual void onWrite(uint8_t i2cAddr, const uint8_t *data, size_t dataLen);
+	virtual void onRead(uint8_t i2cAddr, uint8_t *data, size_t dataLen);
+
+	/**
+	 * @brief Direct access to the simulated array, bypassing the bus
+	 */
+	uint8_t *memory() { return mem; };
+	size_t length() const { return memorySize; };
+
+	/**
+	 * @brief The chip's internal address latch, used by current-address reads
+	 */
+	size_t currentAddress() const { return latch; };
+
+	static const uint8_t DEVICE_ADDR = 0b1010000;
+
+protected:
+	size_t bankOf(uint8_t i2cAddr) const;
+	void advance();
+
+	uint8_t *mem;
+	size_t memorySize;
+	int addr;
+	size_t latch = 0;
+};
+
+#endif /* __FRAMSIM_H */
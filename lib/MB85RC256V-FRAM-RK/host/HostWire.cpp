@@ -0,0 +1,167 @@
+#include "HostWire.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+TwoWire Wire;
+TwoWire Wire1;
+
+TwoWire::TwoWire(size_t bufferSize) : bufferSize(bufferSize) {
+	resetStats();
+}
+
+TwoWire::~TwoWire() {
+}
+
+void TwoWire::setSpeed(uint32_t clockSpeed) {
+	this->clockSpeed = clockSpeed;
+}
+
+void TwoWire::begin() {
+	enabled = true;
+}
+
+void TwoWire::end() {
+	enabled = false;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+	txAddress = address;
+	txBuf.clear();
+	transmitting = true;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+	if (!transmitting) {
+		return 4;
+	}
+	transmitting = false;
+
+	I2CDevice *device = find(txAddress);
+	if (!device) {
+		// Address byte was NACKed, the master sends STOP regardless of sendStop
+		account(0, true);
+		busStats.nacks++;
+		return 2;
+	}
+
+	device->onWrite(txAddress, txBuf.data(), txBuf.size());
+	account(txBuf.size(), sendStop);
+	busStats.bytesWritten += txBuf.size();
+	return 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+	if (!transmitting || txBuf.size() >= bufferSize) {
+		return 0;
+	}
+	txBuf.push_back(data);
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len) {
+	size_t count = 0;
+	while(count < len && write(data[count])) {
+		count++;
+	}
+	return count;
+}
+
+size_t TwoWire::requestFrom(uint8_t address, size_t quantity, uint8_t sendStop) {
+	rxBuf.clear();
+	rxIndex = 0;
+
+	if (quantity > bufferSize) {
+		// Device OS silently truncates requests to the receive buffer size
+		quantity = bufferSize;
+	}
+
+	I2CDevice *device = find(address);
+	if (!device) {
+		account(0, true);
+		busStats.nacks++;
+		return 0;
+	}
+
+	rxBuf.resize(quantity);
+	device->onRead(address, rxBuf.data(), quantity);
+	account(quantity, sendStop);
+	busStats.bytesRead += quantity;
+	return quantity;
+}
+
+int TwoWire::available() {
+	return (int)(rxBuf.size() - rxIndex);
+}
+
+int TwoWire::read() {
+	if (rxIndex >= rxBuf.size()) {
+		return -1;
+	}
+	return rxBuf[rxIndex++];
+}
+
+int TwoWire::peek() {
+	if (rxIndex >= rxBuf.size()) {
+		return -1;
+	}
+	return rxBuf[rxIndex];
+}
+
+bool TwoWire::lock() {
+	mutex.lock();
+	lockDepth++;
+	return true;
+}
+
+bool TwoWire::unlock() {
+	assert(lockDepth > 1 || !busHeld);
+	lockDepth--;
+	mutex.unlock();
+	return true;
+}
+
+void TwoWire::attach(I2CDevice *device) {
+	devices.push_back(device);
+}
+
+void TwoWire::detach(I2CDevice *device) {
+	devices.erase(std::remove(devices.begin(), devices.end(), device), devices.end());
+}
+
+void TwoWire::resetStats() {
+	memset(&busStats, 0, sizeof(busStats));
+}
+
+void TwoWire::setBufferSize(size_t size) {
+	bufferSize = size;
+}
+
+I2CDevice *TwoWire::find(uint8_t address) const {
+	for(I2CDevice *device : devices) {
+		if (device->matches(address)) {
+			return device;
+		}
+	}
+	return nullptr;
+}
+
+void TwoWire::account(size_t dataBytes, bool stop) {
+	// START (or repeated START) + address byte + ACK, then 8 bits + ACK/NACK per data byte
+	uint64_t bits = 1 + 9 + 9 * dataBytes;
+	if (stop) {
+		bits++;
+	}
+
+	busHeld = !stop;
+	busStats.transactions++;
+	busStats.bits += bits;
+
+	uint64_t scaled = bits * 1000000 + bitTimeRemainder;
+	uint64_t us = scaled / clockSpeed;
+	bitTimeRemainder = scaled % clockSpeed;
+
+	busStats.busMicros += us;
+	hostClockAdvanceMicros(us);
+}
@@ -0,0 +1,158 @@
+#ifndef __HOSTWIRE_H
+#define __HOSTWIRE_H
+
+// Host-side (Linux) stand-in for the Device OS TwoWire class. Not used on-device.
+//
+// Transactions are delivered to simulated I2CDevice objects attached to the bus instead of
+// real hardware, and every transaction is accounted for in BusStats using a simple bit-time
+// model of the I2C bus so driver changes can be compared without hardware in the loop.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Called by TwoWire to advance the host clock by the modeled bus time of each transaction
+ *
+ * Implemented by the host environment (host/Particle.cpp) so millis() and micros() track bus time.
+ */
+void hostClockAdvanceMicros(uint64_t us);
+
+/**
+ * @brief Interface for a simulated device on the host I2C bus
+ */
+class I2CDevice {
+public:
+	virtual ~I2CDevice() {};
+
+	/**
+	 * @brief Returns true if this device ACKs the 7-bit I2C address
+	 */
+	virtual bool matches(uint8_t i2cAddr) const = 0;
+
+	/**
+	 * @brief A master write transaction was addressed to this device
+	 *
+	 * @param i2cAddr The 7-bit address that was used. Devices like the MB85RC1M decode bits from it.
+	 *
+	 * @param data The bytes written after the address byte
+	 *
+	 * @param dataLen The number of bytes written
+	 */
+	virtual void onWrite(uint8_t i2cAddr, const uint8_t *data, size_t dataLen) = 0;
+
+	/**
+	 * @brief A master read transaction was addressed to this device
+	 *
+	 * @param i2cAddr The 7-bit address that was used
+	 *
+	 * @param data Buffer to fill with the bytes the device clocks out
+	 *
+	 * @param dataLen Number of bytes requested by the master
+	 */
+	virtual void onRead(uint8_t i2cAddr, uint8_t *data, size_t dataLen) = 0;
+};
+
+/**
+ * @brief Counters for all traffic that crossed a host TwoWire bus
+ */
+struct BusStats {
+	uint32_t transactions;      // START and repeated-START conditions
+	uint32_t nacks;             // Transactions that were not acknowledged by any device
+	uint64_t bytesWritten;      // Data bytes sent by the master, not including the address byte
+	uint64_t bytesRead;         // Data bytes received by the master
+	uint64_t busMicros;         // Modeled time the bus was busy
+
+	/**
+	 * @brief Total bits clocked on SDA/SCL, counting ACK bits and START/STOP
+	 */
+	uint64_t bits;
+};
+
+class TwoWire {
+public:
+	static const size_t DEFAULT_BUFFER_SIZE = 32;
+
+	TwoWire(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+	virtual ~TwoWire();
+
+	void setSpeed(uint32_t clockSpeed);
+	uint32_t getSpeed() const { return clockSpeed; };
+
+	void begin();
+	void end();
+	bool isEnabled() const { return enabled; };
+
+	void beginTransmission(uint8_t address);
+	void beginTransmission(int address) { beginTransmission((uint8_t)address); };
+	uint8_t endTransmission(uint8_t sendStop = true);
+
+	size_t write(uint8_t data);
+	size_t write(const uint8_t *data, size_t len);
+
+	size_t requestFrom(uint8_t address, size_t quantity, uint8_t sendStop = true);
+	size_t requestFrom(int address, size_t quantity, bool sendStop = true) { return requestFrom((uint8_t)address, quantity, (uint8_t)sendStop); };
+
+	int available();
+	int read();
+	int peek();
+
+	bool lock();
+
+	/**
+	 * @brief Releases the bus lock. Asserts that the outermost unlock does not leave a transaction
+	 * open without a STOP, which would hold the bus for whoever locks it next.
+	 */
+	bool unlock();
+
+	/**
+	 * @brief Attach a simulated device to the bus. The device is not owned by the bus.
+	 */
+	void attach(I2CDevice *device);
+
+	/**
+	 * @brief Remove a simulated device from the bus
+	 */
+	void detach(I2CDevice *device);
+
+	/**
+	 * @brief Returns the traffic counters accumulated since construction or the last resetStats()
+	 */
+	const BusStats &stats() const { return busStats; };
+
+	void resetStats();
+
+	/**
+	 * @brief Change the size of the transmit and receive buffers
+	 *
+	 * This mirrors acquireWireBuffer() on Device OS, which lets an application enlarge the
+	 * default 32 byte buffers at startup.
+	 */
+	void setBufferSize(size_t size);
+	size_t getBufferSize() const { return bufferSize; };
+
+protected:
+	I2CDevice *find(uint8_t address) const;
+	void account(size_t dataBytes, bool stop);
+
+	std::recursive_mutex mutex;
+	std::vector<I2CDevice *> devices;
+	std::vector<uint8_t> txBuf;
+	std::vector<uint8_t> rxBuf;
+	size_t rxIndex = 0;
+	size_t bufferSize;
+	uint8_t txAddress = 0;
+	bool transmitting = false;
+	bool busHeld = false;          // The last transaction ended without a STOP
+	int lockDepth = 0;
+	bool enabled = false;
+	uint32_t clockSpeed = 100000;
+	uint64_t bitTimeRemainder = 0; // Fraction of a microsecond carried between transactions, in 1/clockSpeed units
+	BusStats busStats;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif /* __HOSTWIRE_H */
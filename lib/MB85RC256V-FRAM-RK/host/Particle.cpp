@@ -0,0 +1,59 @@
+#include "Particle.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+const Logger Log;
+HostSerial Serial;
+
+static uint64_t hostMicros = 0;
+
+void hostClockAdvanceMicros(uint64_t us) {
+	hostMicros += us;
+}
+
+unsigned long millis() {
+	return (unsigned long)(hostMicros / 1000);
+}
+
+unsigned long micros() {
+	return (unsigned long)hostMicros;
+}
+
+void delay(unsigned long ms) {
+	hostClockAdvanceMicros((uint64_t)ms * 1000);
+}
+
+static void logv(const char *level, const char *fmt, va_list ap) {
+	printf("%010lu [app] %s: ", millis(), level);
+	vprintf(fmt, ap);
+	printf("\n");
+}
+
+void Logger::trace(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logv("TRACE", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::info(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logv("INFO", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::warn(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logv("WARN", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::error(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logv("ERROR", fmt, ap);
+	va_end(ap);
+}
@@ -0,0 +1,56 @@
+#ifndef __PARTICLE_HOST_H
+#define __PARTICLE_HOST_H
+
+// Minimal host-side (Linux) stand-in for the parts of Particle.h used by the MB85RC driver and
+// its examples. This lets the driver and the benchmark suite build with a native compiler:
+//
+//   g++ -std=c++11 -O2 -Ihost -Isrc -Iexamples/test1m host/*.cpp src/*.cpp examples/test1m/FramBench.cpp -o fram-bench
+//
+// The clock only advances with modeled I2C bus time (and delay()), so timings are repeatable.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <type_traits>
+
+#include "HostWire.h"
+
+#define PARTICLE_HOST_SIM 1
+
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+
+#define WITH_LOCK(lock) for (std::unique_lock<std::remove_reference<decltype(lock)>::type> __lock##lock((lock)); __lock##lock; __lock##lock.unlock())
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+class Logger {
+public:
+	void trace(const char *fmt, ...) const;
+	void info(const char *fmt, ...) const;
+	void warn(const char *fmt, ...) const;
+	void error(const char *fmt, ...) const;
+};
+
+extern const Logger Log;
+
+class SerialLogHandler {
+public:
+	SerialLogHandler() {};
+};
+
+class HostSerial {
+public:
+	void begin(int) {};
+	bool isConnected() { return true; };
+};
+
+extern HostSerial Serial;
+
+template <typename T> bool waitFor(T, unsigned long) { return true; }
+
+#endif /* __PARTICLE_HOST_H */
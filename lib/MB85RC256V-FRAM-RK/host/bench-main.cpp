@@ -0,0 +1,58 @@
+// Host entry point for the FRAM benchmark suite in examples/test1m. Runs the same verification and
+// benchmarks as the on-device example against a simulated part of every MB85RC device class,
+// all sharing one simulated Wire bus. See host/Particle.h for the build command.
+
+#include "Particle.h"
+#include "MB85RC256V-FRAM-RK.h"
+#include "FramBench.h"
+#include "FramSim.h"
+
+#include <stdio.h>
+
+int main(int argc, char *argv[]) {
+	if (argc > 1) {
+		// Optional bus clock in Hz, for example 400000
+		Wire.setSpeed((uint32_t)strtoul(argv[1], NULL, 0));
+	}
+	if (argc > 2) {
+		// Optional Wire buffer size, as if enlarged by acquireWireBuffer() on the device
+		Wire.setBufferSize(strtoul(argv[2], NULL, 0));
+	}
+
+	// MB85RC1M uses addresses 0 and 1 (bank select) so the others start at 2
+	FramSim sim64(8192, 2), sim256(32768, 4), sim512(65536, 6), sim1m(131072, 0);
+	Wire.attach(&sim64);
+	Wire.attach(&sim256);
+	Wire.attach(&sim512);
+	Wire.attach(&sim1m);
+
+	MB85RC64 fram64(Wire, 2);
+	MB85RC256V fram256(Wire, 4);
+	MB85RC512 fram512(Wire, 6);
+	MB85RC1M fram1m(Wire, 0);
+
+	FramBench benches[] = {
+		FramBench(fram64, Wire, "MB85RC64"),
+		FramBench(fram256, Wire, "MB85RC256V"),
+		FramBench(fram512, Wire, "MB85RC512"),
+		FramBench(fram1m, Wire, "MB85RC1M")
+	};
+
+	MB85RC *frams[] = { &fram64, &fram256, &fram512, &fram1m };
+	for(MB85RC *fram : frams) {
+		fram->setReadChunkSize(Wire.getBufferSize());
+	}
+
+	fram64.begin();
+
+	Log.info("bus clock %lu Hz, buffer %u bytes", (unsigned long)Wire.getSpeed(), Wire.getBufferSize());
+
+	bool result = true;
+	for(FramBench &bench : benches) {
+		if (!bench.run()) {
+			result = false;
+		}
+	}
+
+	return result ? 0 : 1;
+}
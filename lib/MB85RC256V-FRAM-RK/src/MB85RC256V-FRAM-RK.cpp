@@ -15,27 +15,29 @@ void MB85RC::begin() {
 }
 
 bool MB85RC::erase() {
+	return fill(0, 0, memorySize);
+}
 
-	WITH_LOCK(wire) {
-		size_t framAddr = 0;
-		size_t totalLen = memorySize;
-
-		uint8_t zero[30];
-		memset(zero, 0, sizeof(zero));
+bool MB85RC::fill(size_t framAddr, uint8_t value, size_t numBytes) {
 
-		while(totalLen > 0) {
-			size_t count = totalLen;
-			if (count > sizeof(zero)) {
-				count = sizeof(zero);
+	WITH_LOCK(wire) {
+		// Maximum number of bytes we can write is 30
+		uint8_t buf[30];
+		memset(buf, value, sizeof(buf));
+
+		while(numBytes > 0) {
+			size_t count = numBytes;
+			if (count > sizeof(buf)) {
+				count = sizeof(buf);
 			}
 
-			bool result = writeData(framAddr, zero, count);
+			bool result = writeData(framAddr, buf, count);
 			if (!result) {
-				Log.info("writeData failed during erase framAddr=%u", framAddr);
+				Log.info("writeData failed during fill framAddr=%u", framAddr);
 				return false;
 			}
 
-			totalLen -= count;
+			numBytes -= count;
 			framAddr += count;
 		}
 	}
@@ -43,67 +45,220 @@ bool MB85RC::erase() {
 	return true;
 }
 
+bool MB85RC::startFill(size_t framAddr, uint8_t value, size_t numBytes) {
+	if (framAddr >= memorySize) {
+		return false;
+	}
+	if (numBytes == 0) {
+		numBytes = memorySize - framAddr;
+	}
+	if (numBytes > memorySize - framAddr) {
+		return false;
+	}
+
+	fillAddr = framAddr;
+	fillValue = value;
+	fillTotal = numBytes;
+	fillRemaining = numBytes;
+	return true;
+}
+
+bool MB85RC::fillProcess(size_t maxBytes) {
+	if (fillRemaining == 0) {
+		return true;
+	}
+
+	size_t count = fillRemaining;
+	if (count > maxBytes) {
+		count = maxBytes;
+	}
+
+	if (!fill(fillAddr, fillValue, count)) {
+		fillRemaining = 0;
+		return false;
+	}
+
+	fillAddr += count;
+	fillRemaining -= count;
+	return true;
+}
+
+int MB85RC::getFillProgress() const {
+	if (fillTotal == 0) {
+		return 100;
+	}
+	return (int)((uint64_t)(fillTotal - fillRemaining) * 100 / fillTotal);
+}
+
 
 bool MB85RC::readData(size_t framAddr, uint8_t *data, size_t dataLen) {
+	MB85RCSegment segment = { framAddr, data, dataLen };
+	return readv(&segment, 1);
+}
+
+
+bool MB85RC::writeData(size_t framAddr, const uint8_t *data, size_t dataLen) {
+	MB85RCSegment segment = { framAddr, const_cast<uint8_t *>(data), dataLen };
+	return writev(&segment, 1);
+}
+
+
+bool MB85RC::readv(const MB85RCSegment *segments, size_t numSegments) {
 	bool result = true;
 
 	WITH_LOCK(wire) {
+		size_t seg = 0;
+		size_t segOffset = 0;
 
-		while(dataLen > 0) {
-			wire.beginTransmission(addr | DEVICE_ADDR);
-			wire.write(framAddr >> 8);
-			wire.write(framAddr);
-			int stat = wire.endTransmission(false);
-			if (stat != 0) {
-				//Serial.printlnf("read set address failed %d", stat);
-				result = false;
-				break;
+		while(seg < numSegments && result) {
+			if (segments[seg].dataLen == 0) {
+				seg++;
+				continue;
 			}
 
-			size_t bytesToRead = dataLen;
-			if (bytesToRead > 32) {
-				bytesToRead = 32;
+			// A run is a set of segments that are contiguous in the FRAM. It is read with one address
+			// phase, then sequential reads that are scattered into the segment buffers as they arrive.
+			size_t framAddr = segments[seg].framAddr;
+			size_t runLen = segments[seg].dataLen;
+			size_t runEndSeg = seg + 1;
+			while(runEndSeg < numSegments && segments[runEndSeg].framAddr == framAddr + runLen) {
+				runLen += segments[runEndSeg].dataLen;
+				runEndSeg++;
+			}
+			// Empty segments after this run do not need the bus, so they must not keep it from being released
+			bool lastRun = true;
+			for(size_t ii = runEndSeg; ii < numSegments; ii++) {
+				if (segments[ii].dataLen != 0) {
+					lastRun = false;
+					break;
+				}
 			}
 
-			wire.requestFrom(addr | DEVICE_ADDR, bytesToRead, true);
+			// The FRAM increments its internal address latch on every byte read, so after one address
+			// phase the following reads are current address reads that continue where the last one stopped.
+			size_t endAddr = 0;
+			int i2cAddr = 0;
+
+			while(runLen > 0) {
+				if (endAddr == 0 || framAddr >= endAddr) {
+					// Start of the run, or crossed into the next bank (MB85RC1M)
+					i2cAddr = i2cAddrFor(framAddr);
+					wire.beginTransmission(i2cAddr);
+					wire.write(framAddr >> 8);
+					wire.write(framAddr);
+					int stat = wire.endTransmission(false);
+					if (stat != 0) {
+						//Serial.printlnf("read set address failed %d", stat);
+						result = false;
+						break;
+					}
+					endAddr = bankEnd(framAddr);
+				}
 
-			if (Wire.available() < (int) bytesToRead) {
-				result = false;
-				break;
+				size_t bytesToRead = runLen;
+				if (bytesToRead > readChunkSize) {
+					bytesToRead = readChunkSize;
+				}
+				if (bytesToRead > endAddr - framAddr) {
+					bytesToRead = endAddr - framAddr;
+				}
+
+				// Only release the bus after the last chunk of the last run
+				wire.requestFrom(i2cAddr, bytesToRead, lastRun && (bytesToRead == runLen));
+
+				// The Wire buffer may be smaller than readChunkSize, in which case we get fewer bytes
+				// and the next read picks up from there
+				int avail = wire.available();
+				if (avail <= 0) {
+					result = false;
+					break;
+				}
+				if (avail > (int) bytesToRead) {
+					avail = (int) bytesToRead;
+				}
+
+				for(int ii = 0; ii < avail; ii++) {
+					while(segOffset >= segments[seg].dataLen) {
+						seg++;
+						segOffset = 0;
+					}
+					((uint8_t *)segments[seg].data)[segOffset++] = wire.read();    // receive a byte as character
+				}
+				framAddr += avail;
+				runLen -= avail;
 			}
 
-			for(size_t ii = 0; ii < bytesToRead; ii++) {
-				*data++ = Wire.read();    // receive a byte as character
-				framAddr++;
-				dataLen--;
+			if (!result) {
+				// The failed transaction may have ended without a STOP. An address only write ends it,
+				// so the bus is not left held when the lock is released.
+				wire.beginTransmission(i2cAddr);
+				wire.endTransmission(true);
+				break;
 			}
+
+			seg = runEndSeg;
+			segOffset = 0;
 		}
 	}
 	return result;
 }
 
 
-bool MB85RC::writeData(size_t framAddr, const uint8_t *data, size_t dataLen) {
+bool MB85RC::writev(const MB85RCSegment *segments, size_t numSegments) {
 	bool result = true;
 
 	WITH_LOCK(wire) {
-		while(dataLen > 0) {
-			wire.beginTransmission(addr | DEVICE_ADDR);
-			wire.write(framAddr >> 8);
-			wire.write(framAddr);
-
-			for(size_t ii = 0; ii < 30 && dataLen > 0; ii++) {
-				wire.write(*data);
-				framAddr++;
-				data++;
-				dataLen--;
+		// Data bytes in the write transaction that is currently open, 0 if none is open
+		size_t txCount = 0;
+		size_t nextAddr = 0;
+		size_t endAddr = 0;
+
+		for(size_t seg = 0; seg < numSegments && result; seg++) {
+			size_t framAddr = segments[seg].framAddr;
+			const uint8_t *data = (const uint8_t *)segments[seg].data;
+			size_t dataLen = segments[seg].dataLen;
+
+			while(dataLen > 0) {
+				if (txCount > 0 && (framAddr != nextAddr || txCount >= WRITE_CHUNK_SIZE || framAddr >= endAddr)) {
+					int stat = wire.endTransmission(true);
+					txCount = 0;
+					if (stat != 0) {
+						//Serial.printlnf("write failed %d", stat);
+						result = false;
+						break;
+					}
+				}
+				if (txCount == 0) {
+					wire.beginTransmission(i2cAddrFor(framAddr));
+					wire.write(framAddr >> 8);
+					wire.write(framAddr);
+					endAddr = bankEnd(framAddr);
+				}
+
+				size_t count = dataLen;
+				if (count > WRITE_CHUNK_SIZE - txCount) {
+					count = WRITE_CHUNK_SIZE - txCount;
+				}
+				if (framAddr < endAddr && count > endAddr - framAddr) {
+					// Crosses a bank boundary (MB85RC1M), only write up to the boundary
+					count = endAddr - framAddr;
+				}
+
+				for(size_t ii = 0; ii < count; ii++) {
+					wire.write(*data++);
+				}
+				txCount += count;
+				framAddr += count;
+				dataLen -= count;
+				nextAddr = framAddr;
 			}
+		}
 
+		if (result && txCount > 0) {
 			int stat = wire.endTransmission(true);
 			if (stat != 0) {
 				//Serial.printlnf("write failed %d", stat);
 				result = false;
-				break;
 			}
 		}
 	}
@@ -169,98 +324,8 @@ bool MB85RC::moveData(size_t framAddrFrom, size_t framAddrTo, size_t numBytes) {
 }
 
 
-
-//
-// Special versions of readData and writeData are required for the MB85RC1M
-//
-
-bool MB85RC1M::readData(size_t framAddr, uint8_t *data, size_t dataLen) {
-	bool result = true;
-
-	WITH_LOCK(wire) {
-
-		while(dataLen > 0) {
-			size_t count = dataLen;
-			if (count > 32) {
-				// Don't read more than 32 bytes (limit of Wire implementation)
-				count = 32;
-			}
-			if ((framAddr < 65536) && ((framAddr + count) >= 65536)) {
-				// Crosses boundary at 65536, only write up to the boundary
-				count = 65536 - framAddr;
-			}
-
-			wire.beginTransmission(getI2CAddr(framAddr));
-			wire.write(framAddr >> 8);
-			wire.write(framAddr);
-			int stat = wire.endTransmission(false);
-			if (stat != 0) {
-				Log.info("read set address failed %d", stat);
-				result = false;
-				break;
-			}
-
-			wire.requestFrom(getI2CAddr(framAddr), count, true);
-
-			if (Wire.available() < (int) count) {
-				Log.info("didn't receive enough bytes count=%u", count);
-				result = false;
-				break;
-			}
-
-			for(size_t ii = 0; ii < count; ii++) {
-				*data++ = Wire.read();    // receive a byte as character
-				framAddr++;
-				dataLen--;
-			}
-		}
-	}
-	return result;
-}
-
-bool MB85RC1M::writeData(size_t framAddr, const uint8_t *data, size_t dataLen) {
-	bool result = true;
-
-	WITH_LOCK(wire) {
-		while(dataLen > 0) {
-			size_t count = dataLen;
-			if (count > 30) {
-				// Don't write more than 30 bytes (limit of Wire implementation)
-				count = 30;
-			}
-			if ((framAddr < 65536) && ((framAddr + count) >= 65536)) {
-				// Crosses boundary at 65536, only write up to the boundary
-				count = 65536 - framAddr;
-			}
-
-			wire.beginTransmission(getI2CAddr(framAddr));
-			wire.write(framAddr >> 8);
-			wire.write(framAddr);
-
-			for(size_t ii = 0; ii < count; ii++) {
-				wire.write(*data);
-				framAddr++;
-				data++;
-				dataLen--;
-				count--;
-			}
-
-			int stat = wire.endTransmission(true);
-			if (stat != 0) {
-				Log.info("write failed %d", stat);
-				result = false;
-				break;
-			}
-		}
-	}
-	return result;
-}
-
 int MB85RC1M::getI2CAddr(size_t framAddr) const {
 	return addr | DEVICE_ADDR | (framAddr >= 65536 ? 1 : 0);
 }
 
 
-
-
-
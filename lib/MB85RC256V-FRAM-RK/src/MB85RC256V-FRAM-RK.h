@@ -3,6 +3,15 @@
 
 #include "Particle.h"
 
+/**
+ * @brief One contiguous range of FRAM and the buffer it is read into or written from, for readv() and writev()
+ */
+struct MB85RCSegment {
+	size_t framAddr;     //!< Address in the FRAM
+	void *data;          //!< Buffer to read into or write from. Only read from by writev().
+	size_t dataLen;      //!< Number of bytes
+};
+
 class MB85RC {
 public:
 	/**
@@ -31,10 +40,71 @@ public:
 	/**
 	 * @brief Erases the FRAM device
 	 *
-	 * This is generally a slow operation because it requires writing to every location.
+	 * This is generally a slow operation because it requires writing to every location, and it holds
+	 * the Wire lock for the whole time. Use startErase() and fillProcess() to erase in the background.
 	 */
 	bool erase();
 
+	/**
+	 * @brief Erases (sets to 0) a range of the FRAM
+	 *
+	 * @param framAddr The first address to erase
+	 *
+	 * @param numBytes The number of bytes to erase
+	 */
+	bool erase(size_t framAddr, size_t numBytes) { return fill(framAddr, 0, numBytes); };
+
+	/**
+	 * @brief Sets a range of the FRAM to a value
+	 *
+	 * @param framAddr The first address to set
+	 *
+	 * @param value The value to store in every byte
+	 *
+	 * @param numBytes The number of bytes to set
+	 */
+	bool fill(size_t framAddr, uint8_t value, size_t numBytes);
+
+	/**
+	 * @brief Starts setting a range of the FRAM to a value in the background
+	 *
+	 * @param framAddr The first address to set
+	 *
+	 * @param value The value to store in every byte
+	 *
+	 * @param numBytes The number of bytes to set. 0 means to the end of the FRAM.
+	 *
+	 * Nothing is written until fillProcess() is called, typically from loop(). Starting a new fill
+	 * abandons any fill that is in progress. Returns false if the range is not within the device.
+	 */
+	bool startFill(size_t framAddr, uint8_t value, size_t numBytes = 0);
+
+	/**
+	 * @brief Starts erasing a range of the FRAM in the background. By default, the whole device.
+	 */
+	bool startErase(size_t framAddr = 0, size_t numBytes = 0) { return startFill(framAddr, 0, numBytes); };
+
+	/**
+	 * @brief Does one bounded slice of a background fill or erase. Call this from loop().
+	 *
+	 * @param maxBytes The maximum number of bytes to write on this call. The Wire lock is only held
+	 * for the duration of the slice. The default of 240 bytes is about 25 milliseconds on a 100 kHz bus.
+	 *
+	 * Returns false if a write failed, which also ends the background operation. Returns true if
+	 * no background operation is in progress.
+	 */
+	bool fillProcess(size_t maxBytes = 240);
+
+	/**
+	 * @brief Returns true if a background fill or erase is in progress
+	 */
+	bool isFillBusy() const { return fillRemaining > 0; };
+
+	/**
+	 * @brief Returns the progress of the current or last background fill or erase, 0 - 100
+	 */
+	int getFillProgress() const;
+
 	/**
 	 * @brief Read from FRAM using EEPROM-style API
 	 *
@@ -57,6 +127,22 @@ public:
         return t;
     }
 
+	/**
+	 * @brief Read a typed field (MB85RCField, see MB85RCLayout.h)
+	 */
+	template <typename F> typename F::Type get() {
+		typename F::Type t;
+		readData(F::addr, (uint8_t *)&t, F::size);
+		return t;
+	}
+
+	/**
+	 * @brief Write a typed field (MB85RCField, see MB85RCLayout.h)
+	 */
+	template <typename F> bool put(const typename F::Type &t) {
+		return writeData(F::addr, (const uint8_t *)&t, F::size);
+	}
+
     /**
      * @brief Low-level read call
      *
@@ -66,10 +152,26 @@ public:
 	 *
 	 * @param dataLen The number of bytes to read
 	 *
-	 * The dataLen can be larger than the maximum I2C read. Multiple reads will be done if necessary.
+	 * The dataLen can be larger than the maximum I2C read. The FRAM address is only sent once and the
+	 * data is streamed with sequential reads of up to getReadChunkSize() bytes each, as the FRAM
+	 * increments its internal address after every byte read.
      */
 	virtual bool readData(size_t framAddr, uint8_t *data, size_t dataLen);
 
+	/**
+	 * @brief Sets the maximum number of bytes requested from the Wire interface in a single requestFrom()
+	 *
+	 * The default is 32, the size of the default Wire receive buffer. If you have enlarged the Wire buffers
+	 * using acquireWireBuffer() you can set this to match to reduce the number of I2C transactions for
+	 * large reads.
+	 */
+	void setReadChunkSize(size_t size) { readChunkSize = size ? size : 1; };
+
+	/**
+	 * @brief Returns the maximum number of bytes requested in a single requestFrom(). Default: 32.
+	 */
+	size_t getReadChunkSize() const { return readChunkSize; };
+
     /**
      * @brief Low-level write call
      *
@@ -94,12 +196,61 @@ public:
 	 */
 	virtual bool moveData(size_t framAddrFrom, size_t framAddrTo, size_t numBytes);
 
+	/**
+	 * @brief Read several ranges of FRAM in one bus session (scatter)
+	 *
+	 * @param segments Array of ranges and the buffers to read them into
+	 *
+	 * @param numSegments Number of entries in segments
+	 *
+	 * All segments are read under a single Wire lock. When a segment starts where the previous one
+	 * ended, the FRAM address is not sent again and the read just continues sequentially, so sorting
+	 * the segments by address and making them adjacent gives the fewest transactions.
+	 */
+	bool readv(const MB85RCSegment *segments, size_t numSegments);
+
+	/**
+	 * @brief Write several ranges of FRAM in one bus session (gather)
+	 *
+	 * @param segments Array of ranges and the buffers to write them from
+	 *
+	 * @param numSegments Number of entries in segments
+	 *
+	 * All segments are written under a single Wire lock. Segments that start where the previous one
+	 * ended are packed into the same I2C write transactions.
+	 */
+	bool writev(const MB85RCSegment *segments, size_t numSegments);
+
 	static const uint8_t DEVICE_ADDR = 0b1010000;
 
+	static const size_t DEFAULT_READ_CHUNK_SIZE = 32;
+
+	/**
+	 * @brief Maximum data bytes per I2C write: the 32 byte Wire buffer less the 2 address bytes
+	 */
+	static const size_t WRITE_CHUNK_SIZE = 30;
+
 protected:
+	/**
+	 * @brief Returns the 7-bit I2C address used to access framAddr
+	 */
+	virtual int i2cAddrFor(size_t /*framAddr*/) const { return addr | DEVICE_ADDR; };
+
+	/**
+	 * @brief Returns the end of the range that can be accessed sequentially starting at framAddr
+	 */
+	virtual size_t bankEnd(size_t /*framAddr*/) const { return memorySize; };
+
 	TwoWire &wire;
 	size_t memorySize;
 	int addr; // This is just 0-7, the (0b1010000 of the 7-bit address is ORed in later)
+	size_t readChunkSize = DEFAULT_READ_CHUNK_SIZE;
+
+	// Background fill state (startFill, fillProcess)
+	size_t fillAddr = 0;
+	size_t fillRemaining = 0;
+	size_t fillTotal = 0;
+	uint8_t fillValue = 0;
 
 };
 
@@ -158,39 +309,18 @@ public:
 	 */
 	MB85RC1M(TwoWire &wire, int addr = 0) : MB85RC(wire, 131072, addr & 6) {};
 
-    /**
-     * @brief Low-level read call
-     *
-	 * @param framAddr The address in the FRAM to read from
-	 *
-	 * @param data The buffer to read into
-	 *
-	 * @param dataLen The number of bytes to read
-	 *
-	 * The dataLen can be larger than the maximum I2C read. Multiple reads will be done if necessary.
-	 *
-	 * On the MB85RC1M reads across the framAddr 65536 page boundary are special but this call will break the
-	 * read into multiple reads if necessary so you don't have to worry about it.
-     */
-	virtual bool readData(size_t framAddr, uint8_t *data, size_t dataLen);
-
 	/**
-     * @brief Low-level write call
-     *
-	 * @param framAddr The address in the FRAM to write to
+	 * @brief Returns the I2C address for framAddr. The MB85RC1M uses the low bit of the address for the 64K bank.
 	 *
-	 * @param data The buffer containing the data to write
-	 *
-	 * @param dataLen The number of bytes to write
-	 *
-	 * The dataLen can be larger than the maximum I2C write. Multiple writes will be done if necessary.
-	 *
-	 * On the MB85RC1M writes across the framAddr 65536 page boundary are special but this call will break the
-	 * read into multiple reads if necessary so you don't have to worry about it.
-     */
-	virtual bool writeData(size_t framAddr, const uint8_t *data, size_t dataLen);
-
+	 * On the MB85RC1M reads and writes across the framAddr 65536 page boundary are special but readData,
+	 * writeData, readv and writev will break the transfer into multiple transactions if necessary so you
+	 * don't have to worry about it.
+	 */
 	int getI2CAddr(size_t framAddr) const;
+
+protected:
+	virtual int i2cAddrFor(size_t framAddr) const { return getI2CAddr(framAddr); };
+	virtual size_t bankEnd(size_t framAddr) const { return (framAddr < 65536) ? 65536 : memorySize; };
 };
 
 
@@ -0,0 +1,192 @@
+#include "Particle.h"
+#include "MB85RCCache.h"
+
+
+MB85RCCache::MB85RCCache(MB85RC &fram, size_t framAddr, uint8_t *buf, size_t len, FlushPolicy policy) :
+	fram(fram), regionAddr(framAddr), buf(buf), regionLen(len), policy(policy) {
+}
+
+MB85RCCache::~MB85RCCache() {
+}
+
+bool MB85RCCache::reload() {
+	numDirty = 0;
+	return fram.readData(regionAddr, buf, regionLen);
+}
+
+bool MB85RCCache::readData(size_t framAddr, uint8_t *data, size_t dataLen) {
+	if (contains(framAddr, dataLen)) {
+		memcpy(data, &buf[framAddr - regionAddr], dataLen);
+		return true;
+	}
+
+	// Partially or completely outside of the region. Make sure the FRAM is current first.
+	if (!flush()) {
+		return false;
+	}
+	return fram.readData(framAddr, data, dataLen);
+}
+
+bool MB85RCCache::writeData(size_t framAddr, const uint8_t *data, size_t dataLen) {
+	if (!contains(framAddr, dataLen)) {
+		// Write through, then update whatever part of the mirror overlaps
+		if (!fram.writeData(framAddr, data, dataLen)) {
+			return false;
+		}
+		size_t start = (framAddr > regionAddr) ? framAddr : regionAddr;
+		size_t end = (framAddr + dataLen < regionAddr + regionLen) ? framAddr + dataLen : regionAddr + regionLen;
+		if (start < end) {
+			memcpy(&buf[start - regionAddr], &data[start - framAddr], end - start);
+		}
+		return true;
+	}
+
+	// Only the bytes that actually changed become dirty
+	size_t offset = framAddr - regionAddr;
+	size_t first = dataLen;
+	size_t last = 0;
+	for(size_t ii = 0; ii < dataLen; ii++) {
+		if (buf[offset + ii] != data[ii]) {
+			buf[offset + ii] = data[ii];
+			if (first == dataLen) {
+				first = ii;
+			}
+			last = ii + 1;
+		}
+	}
+	if (first == dataLen) {
+		// Unchanged, no bus traffic
+		return true;
+	}
+
+	markDirty(offset + first, offset + last);
+	if (policy == WRITE_THROUGH && updateDepth == 0) {
+		return flush();
+	}
+	return true;
+}
+
+bool MB85RCCache::readv(const MB85RCSegment *segments, size_t numSegments) {
+	for(size_t ii = 0; ii < numSegments; ii++) {
+		if (!contains(segments[ii].framAddr, segments[ii].dataLen)) {
+			// At least one is outside of the region, let the FRAM do them all in one session
+			if (!flush()) {
+				return false;
+			}
+			return fram.readv(segments, numSegments);
+		}
+	}
+	for(size_t ii = 0; ii < numSegments; ii++) {
+		memcpy(segments[ii].data, &buf[segments[ii].framAddr - regionAddr], segments[ii].dataLen);
+	}
+	return true;
+}
+
+bool MB85RCCache::writev(const MB85RCSegment *segments, size_t numSegments) {
+	bool result = true;
+
+	beginUpdate();
+	for(size_t ii = 0; ii < numSegments && result; ii++) {
+		result = writeData(segments[ii].framAddr, (const uint8_t *)segments[ii].data, segments[ii].dataLen);
+	}
+	if (!endUpdate()) {
+		result = false;
+	}
+	return result;
+}
+
+bool MB85RCCache::flush() {
+	if (!isDirty()) {
+		return true;
+	}
+
+	MB85RCSegment segments[MAX_DIRTY_RANGES];
+	for(size_t ii = 0; ii < numDirty; ii++) {
+		segments[ii].framAddr = regionAddr + dirtyStart[ii];
+		segments[ii].data = &buf[dirtyStart[ii]];
+		segments[ii].dataLen = dirtyEnd[ii] - dirtyStart[ii];
+	}
+	if (!fram.writev(segments, numDirty)) {
+		return false;
+	}
+	numDirty = 0;
+	return true;
+}
+
+bool MB85RCCache::endUpdate() {
+	if (updateDepth > 0) {
+		updateDepth--;
+	}
+	if (policy == WRITE_THROUGH && updateDepth == 0) {
+		return flush();
+	}
+	return true;
+}
+
+bool MB85RCCache::loop() {
+	if (policy == DEFERRED && isDirty() && millis() - dirtySince >= flushDelayMs) {
+		return flush();
+	}
+	return true;
+}
+
+void MB85RCCache::markDirty(size_t start, size_t end) {
+	if (!isDirty()) {
+		dirtySince = millis();
+	}
+
+	// Insert in order, then merge anything overlapping or touching
+	size_t pos = 0;
+	while(pos < numDirty && dirtyStart[pos] < start) {
+		pos++;
+	}
+	if (numDirty == MAX_DIRTY_RANGES) {
+		// No room: widen the neighbor with the smallest gap instead of inserting
+		size_t gapBefore = (size_t)-1;
+		size_t gapAfter = (size_t)-1;
+		if (pos > 0) {
+			gapBefore = (start > dirtyEnd[pos - 1]) ? start - dirtyEnd[pos - 1] : 0;
+		}
+		if (pos < numDirty) {
+			gapAfter = (dirtyStart[pos] > end) ? dirtyStart[pos] - end : 0;
+		}
+		if (gapBefore <= gapAfter) {
+			pos--;
+			if (end > dirtyEnd[pos]) {
+				dirtyEnd[pos] = end;
+			}
+		}
+		else {
+			if (start < dirtyStart[pos]) {
+				dirtyStart[pos] = start;
+			}
+			if (end > dirtyEnd[pos]) {
+				dirtyEnd[pos] = end;
+			}
+		}
+	}
+	else {
+		for(size_t ii = numDirty; ii > pos; ii--) {
+			dirtyStart[ii] = dirtyStart[ii - 1];
+			dirtyEnd[ii] = dirtyEnd[ii - 1];
+		}
+		dirtyStart[pos] = start;
+		dirtyEnd[pos] = end;
+		numDirty++;
+	}
+
+	size_t out = 0;
+	for(size_t ii = 1; ii < numDirty; ii++) {
+		if (dirtyStart[ii] <= dirtyEnd[out]) {
+			if (dirtyEnd[ii] > dirtyEnd[out]) {
+				dirtyEnd[out] = dirtyEnd[ii];
+			}
+		}
+		else {
+			out++;
+			dirtyStart[out] = dirtyStart[ii];
+			dirtyEnd[out] = dirtyEnd[ii];
+		}
+	}
+	numDirty = out + 1;
+}
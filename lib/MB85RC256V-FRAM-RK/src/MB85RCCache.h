@@ -0,0 +1,179 @@
+#ifndef __MB85RCCACHE_H
+#define __MB85RCCACHE_H
+
+#include "Particle.h"
+#include "MB85RC256V-FRAM-RK.h"
+
+/**
+ * @brief RAM mirror of a region of an MB85RC FRAM
+ *
+ * Reads from the region never touch the I2C bus. Writes update the mirror and, only if the value
+ * actually changed, mark the changed bytes dirty. Up to MAX_DIRTY_RANGES separate dirty ranges are
+ * tracked; beyond that the closest ranges are merged. Dirty bytes are written to the FRAM according to
+ * the flush policy. Accesses outside the region are passed through to the FRAM.
+ *
+ * This is only safe if nothing else writes to the region of the FRAM behind the cache's back. If
+ * that happens (for example after an erase) call reload().
+ *
+ * You will normally use MB85RCCacheStatic, which includes the storage for the mirror.
+ */
+class MB85RCCache {
+public:
+	enum FlushPolicy {
+		WRITE_THROUGH,          //!< Changed bytes are written immediately (default)
+		DEFERRED,               //!< Changed bytes are written from loop() once flushDelayMs has passed
+		ON_DEMAND               //!< Changed bytes are only written by flush()
+	};
+
+	/**
+	 * @param fram The FRAM object to cache
+	 *
+	 * @param framAddr The first FRAM address of the cached region
+	 *
+	 * @param buf RAM to use for the mirror. Must be at least len bytes and remain valid.
+	 *
+	 * @param len The length of the cached region in bytes
+	 *
+	 * @param policy When dirty bytes are written to the FRAM
+	 */
+	MB85RCCache(MB85RC &fram, size_t framAddr, uint8_t *buf, size_t len, FlushPolicy policy = WRITE_THROUGH);
+	virtual ~MB85RCCache();
+
+	/**
+	 * @brief Loads the mirror from the FRAM in one sequential read. Call after fram.begin().
+	 */
+	bool begin() { return reload(); };
+
+	/**
+	 * @brief Discards any dirty bytes and loads the mirror from the FRAM again
+	 */
+	bool reload();
+
+	/**
+	 * @brief Read, from RAM if the range is within the cached region
+	 */
+	bool readData(size_t framAddr, uint8_t *data, size_t dataLen);
+
+	/**
+	 * @brief Write. Within the cached region, only changed bytes are marked dirty.
+	 */
+	bool writeData(size_t framAddr, const uint8_t *data, size_t dataLen);
+
+	/**
+	 * @brief Read using the EEPROM-style API, same as MB85RC::get()
+	 */
+	template <typename T> T &get(size_t framAddr, T &t) {
+		readData(framAddr, (uint8_t *)&t, sizeof(T));
+		return t;
+	}
+
+	/**
+	 * @brief Write using the EEPROM-style API, same as MB85RC::put()
+	 */
+	template <typename T> const T &put(size_t framAddr, const T &t) {
+		writeData(framAddr, (const uint8_t *)&t, sizeof(T));
+		return t;
+	}
+
+	/**
+	 * @brief Read a typed field (MB85RCField, see MB85RCLayout.h)
+	 */
+	template <typename F> typename F::Type get() {
+		typename F::Type t;
+		readData(F::addr, (uint8_t *)&t, F::size);
+		return t;
+	}
+
+	/**
+	 * @brief Write a typed field (MB85RCField, see MB85RCLayout.h)
+	 */
+	template <typename F> bool put(const typename F::Type &t) {
+		return writeData(F::addr, (const uint8_t *)&t, F::size);
+	}
+
+	/**
+	 * @brief Read several ranges, from RAM if they are all within the cached region
+	 */
+	bool readv(const MB85RCSegment *segments, size_t numSegments);
+
+	/**
+	 * @brief Write several ranges. Changes are flushed together, as with beginUpdate() and endUpdate().
+	 */
+	bool writev(const MB85RCSegment *segments, size_t numSegments);
+
+	/**
+	 * @brief Writes the dirty ranges, if any, to the FRAM in one writev call
+	 */
+	bool flush();
+
+	/**
+	 * @brief Groups several writes so they are flushed together in one bus session
+	 *
+	 * Between beginUpdate() and endUpdate() the WRITE_THROUGH policy holds changes in RAM. endUpdate()
+	 * then flushes all of them with a single writev(). Calls can be nested.
+	 */
+	void beginUpdate() { updateDepth++; };
+
+	/**
+	 * @brief Ends a group of writes started with beginUpdate(). Flushes if the policy is WRITE_THROUGH.
+	 */
+	bool endUpdate();
+
+	/**
+	 * @brief Call from loop(). With the DEFERRED policy, flushes once the oldest change is flushDelayMs old.
+	 */
+	bool loop();
+
+	bool isDirty() const { return numDirty > 0; };
+
+	void setFlushPolicy(FlushPolicy policy) { this->policy = policy; };
+	FlushPolicy getFlushPolicy() const { return policy; };
+
+	/**
+	 * @brief How long the DEFERRED policy waits after the first change before writing. Default: 1000 ms.
+	 */
+	void setFlushDelay(unsigned long ms) { flushDelayMs = ms; };
+
+	/**
+	 * @brief Returns true if the whole range is within the cached region
+	 */
+	bool contains(size_t framAddr, size_t dataLen) const {
+		return framAddr >= regionAddr && dataLen <= regionLen && framAddr - regionAddr <= regionLen - dataLen;
+	};
+
+protected:
+	void markDirty(size_t start, size_t end);
+
+public:
+	static const size_t MAX_DIRTY_RANGES = 4;
+
+protected:
+	MB85RC &fram;
+	size_t regionAddr;
+	uint8_t *buf;
+	size_t regionLen;
+	FlushPolicy policy;
+	unsigned long flushDelayMs = 1000;
+	unsigned long dirtySince = 0;
+	int updateDepth = 0;
+	size_t numDirty = 0;
+	size_t dirtyStart[MAX_DIRTY_RANGES];    // Offsets within the region, sorted and non-overlapping
+	size_t dirtyEnd[MAX_DIRTY_RANGES];
+};
+
+/**
+ * @brief MB85RCCache with the mirror storage included
+ *
+ * @param SIZE The length of the cached region in bytes
+ */
+template <size_t SIZE>
+class MB85RCCacheStatic : public MB85RCCache {
+public:
+	MB85RCCacheStatic(MB85RC &fram, size_t framAddr = 0, FlushPolicy policy = WRITE_THROUGH) :
+		MB85RCCache(fram, framAddr, staticBuf, SIZE, policy) {};
+
+protected:
+	uint8_t staticBuf[SIZE];
+};
+
+#endif /* __MB85RCCACHE_H */
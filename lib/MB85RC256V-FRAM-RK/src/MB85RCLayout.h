@@ -0,0 +1,95 @@
+#ifndef __MB85RCLAYOUT_H
+#define __MB85RCLAYOUT_H
+
+#include "Particle.h"
+#include "MB85RC256V-FRAM-RK.h"
+
+/**
+ * @brief A typed field at a fixed address in the FRAM
+ *
+ * @param ADDR The FRAM address of the field
+ *
+ * @param T The type stored. The size comes from sizeof(T).
+ *
+ * Use with the typed get<F>() and put<F>() calls on MB85RC and MB85RCCache, and with MB85RCGroup.
+ */
+template <size_t ADDR, typename T>
+struct MB85RCField {
+	typedef T Type;
+	static constexpr size_t addr = ADDR;
+	static constexpr size_t size = sizeof(T);
+	static constexpr size_t end = ADDR + sizeof(T);
+};
+
+/**
+ * @brief A typed field placed directly after PREV, rounded up to a multiple of ALIGN
+ */
+template <typename PREV, typename T, size_t ALIGN = 1>
+using MB85RCFieldAfter = MB85RCField<(PREV::end + ALIGN - 1) / ALIGN * ALIGN, T>;
+
+namespace MB85RCLayoutDetail {
+	// Fields must be listed in address order; each must end at or before the next one starts
+	template <typename... F> struct Check;
+
+	template <> struct Check<> {
+		static constexpr bool ordered = true;
+		static constexpr size_t end = 0;
+	};
+
+	template <typename A> struct Check<A> {
+		static constexpr bool ordered = true;
+		static constexpr size_t end = A::end;
+	};
+
+	template <typename A, typename B, typename... R> struct Check<A, B, R...> {
+		static constexpr bool ordered = (A::end <= B::addr) && Check<B, R...>::ordered;
+		static constexpr size_t end = Check<B, R...>::end;
+	};
+};
+
+/**
+ * @brief A complete FRAM memory map, checked at compile time
+ *
+ * @param DEVICE_SIZE The size of the FRAM in bytes, for example 8192 for the MB85RC64
+ *
+ * @param F The fields (MB85RCField), in address order
+ *
+ * Fails to compile if any two fields overlap or the last field does not fit in the device.
+ */
+template <size_t DEVICE_SIZE, typename... F>
+struct MB85RCLayout {
+	static_assert(MB85RCLayoutDetail::Check<F...>::ordered, "FRAM fields overlap or are not in address order");
+	static_assert(MB85RCLayoutDetail::Check<F...>::end <= DEVICE_SIZE, "FRAM layout does not fit in the device");
+
+	/**
+	 * @brief The first address after the last field
+	 */
+	static constexpr size_t end = MB85RCLayoutDetail::Check<F...>::end;
+};
+
+/**
+ * @brief A group of fields that are loaded or stored together in one bus session
+ *
+ * @param F The fields, in address order. Fields that are adjacent in the FRAM become a single
+ * sequential transfer (see MB85RC::readv() and writev()).
+ *
+ * Storage can be an MB85RC or an MB85RCCache.
+ */
+template <typename... F>
+struct MB85RCGroup {
+	static_assert(MB85RCLayoutDetail::Check<F...>::ordered, "FRAM group fields overlap or are not in address order");
+
+	template <typename Storage>
+	static bool load(Storage &storage, typename F::Type &... values) {
+		MB85RCSegment segments[] = { { F::addr, &values, F::size }... };
+		return storage.readv(segments, sizeof...(F));
+	}
+
+	template <typename Storage>
+	static bool store(Storage &storage, const typename F::Type &... values) {
+		MB85RCSegment segments[] = { { F::addr, const_cast<typename F::Type *>(&values), F::size }... };
+		return storage.writev(segments, sizeof...(F));
+	}
+};
+
+#endif /* __MB85RCLAYOUT_H */
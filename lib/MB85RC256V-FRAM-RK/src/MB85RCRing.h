@@ -0,0 +1,167 @@
+#ifndef __MB85RCRING_H
+#define __MB85RCRING_H
+
+#include "Particle.h"
+#include "MB85RC256V-FRAM-RK.h"
+
+/**
+ * @brief Persistent FIFO of fixed-size records in FRAM that survives resets
+ *
+ * @param T The record type. It is stored with readData/writeData so it must be trivially copyable.
+ *
+ * @param N The maximum number of records
+ *
+ * push() and pop() are O(1): one record write (push only) plus one header write. The head and count
+ * are committed atomically by alternating between two header slots that each carry a commit number
+ * and a check value. If power is lost in the middle of a header write, the other slot is still valid
+ * and begin() picks it up, so a record is either fully in the queue or not in it at all. A record is
+ * only ever written to a slot no committed header counts, so a push to a full ring first commits the
+ * oldest record dropped, a second header write.
+ *
+ * The FRAM footprint is sizeof(MB85RCRing<T, N>::Storage), which can be used as the type of an
+ * MB85RCField to reserve the space in an MB85RCLayout.
+ */
+template <typename T, size_t N>
+class MB85RCRing {
+public:
+	struct Header {
+		uint32_t commit;        // Incremented on every change, the slot with the higher value is current
+		uint16_t head;          // Index of the oldest record
+		uint16_t count;         // Number of records
+		uint32_t check;         // Guards against a torn write
+	};
+
+	struct Storage {
+		Header headers[2];
+		T records[N];
+	};
+
+	static_assert(N > 0 && N < 65536, "MB85RCRing size must be 1 - 65535");
+
+	/**
+	 * @param fram The FRAM object
+	 *
+	 * @param framAddr The first of sizeof(Storage) bytes of FRAM reserved for the ring
+	 */
+	MB85RCRing(MB85RC &fram, size_t framAddr) : fram(fram), framAddr(framAddr) {};
+
+	/**
+	 * @brief Loads the current header from FRAM. Call after fram.begin().
+	 *
+	 * If neither header slot is valid (new or erased FRAM) the ring is initialized empty.
+	 */
+	bool begin() {
+		Header slots[2];
+		if (!fram.readData(framAddr, (uint8_t *)slots, sizeof(slots))) {
+			return false;
+		}
+
+		bool valid0 = isValid(slots[0]);
+		bool valid1 = isValid(slots[1]);
+		if (valid0 && (!valid1 || (int32_t)(slots[0].commit - slots[1].commit) > 0)) {
+			header = slots[0];
+			slot = 0;
+		}
+		else if (valid1) {
+			header = slots[1];
+			slot = 1;
+		}
+		else {
+			header.commit = 0;
+			header.head = 0;
+			header.count = 0;
+			slot = 1;
+			return commit(0, 0);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Adds a record at the end of the queue
+	 *
+	 * If the queue is full the oldest record is dropped to make room, so the most recent N records are kept.
+	 */
+	bool push(const T &t) {
+		if (header.count == N && !commit((header.head + 1) % N, header.count - 1)) {
+			return false;
+		}
+		size_t index = (header.head + header.count) % N;
+		if (!fram.writeData(recordAddr(index), (const uint8_t *)&t, sizeof(T))) {
+			return false;
+		}
+		return commit(header.head, header.count + 1);
+	}
+
+	/**
+	 * @brief Reads a record without removing it
+	 *
+	 * @param t Filled in with the record
+	 *
+	 * @param index 0 is the oldest record. Must be less than size().
+	 */
+	bool peek(T &t, size_t index = 0) {
+		if (index >= header.count) {
+			return false;
+		}
+		return fram.readData(recordAddr((header.head + index) % N), (uint8_t *)&t, sizeof(T));
+	}
+
+	/**
+	 * @brief Removes the oldest record. Only the header is written.
+	 */
+	bool pop() {
+		if (header.count == 0) {
+			return false;
+		}
+		return commit((header.head + 1) % N, header.count - 1);
+	}
+
+	/**
+	 * @brief Removes all records
+	 */
+	bool clear() {
+		return commit(0, 0);
+	}
+
+	size_t size() const { return header.count; };
+	bool empty() const { return header.count == 0; };
+	bool full() const { return header.count == N; };
+	static constexpr size_t capacity() { return N; };
+
+protected:
+	static uint32_t checkValue(const Header &h) {
+		return ~(h.commit ^ ((uint32_t)h.head << 16 | h.count) ^ 0x52494e47);
+	}
+
+	static bool isValid(const Header &h) {
+		return h.check == checkValue(h) && h.head < N && h.count <= N;
+	}
+
+	size_t recordAddr(size_t index) const {
+		return framAddr + offsetof(Storage, records) + index * sizeof(T);
+	}
+
+	bool commit(size_t head, size_t count) {
+		Header next;
+		next.commit = header.commit + 1;
+		next.head = (uint16_t)head;
+		next.count = (uint16_t)count;
+		next.check = checkValue(next);
+
+		// Always write the slot that is not current so a torn write leaves the current one intact
+		int nextSlot = slot ^ 1;
+		if (!fram.writeData(framAddr + nextSlot * sizeof(Header), (const uint8_t *)&next, sizeof(Header))) {
+			return false;
+		}
+		header = next;
+		slot = nextSlot;
+		return true;
+	}
+
+	MB85RC &fram;
+	size_t framAddr;
+	Header header = { 0, 0, 0, 0 };
+	int slot = 0;
+};
+
+#endif /* __MB85RCRING_H */
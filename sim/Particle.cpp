@@ -0,0 +1,300 @@
+#include "Particle.h"
+
+#include <stdarg.h>
+#include <map>
+#include <vector>
+
+const Logger Log;
+TimeClass Time;
+CellularClass Cellular;
+ParticleClass Particle;
+SystemClass System;
+
+namespace {
+  const uint64_t MODEM_ON_MICROS = 2000000;                             // Power on to answering AT commands
+  const uint64_t CELLULAR_CONNECT_MICROS = 20000000;                   // Modem on to registered
+  const uint64_t CLOUD_CONNECT_MICROS = 3000000;                       // Registered to cloud session
+  const uint64_t WAIT_STEP_MICROS = 100000;                             // waitFor() checks its condition this often
+  const uint64_t ADC_MICROS = 5;                                        // One analogRead() conversion
+
+  int pinLevels[TOTAL_PINS];
+  PinMode pinModes[TOTAL_PINS];
+  void (*interruptHandlers[TOTAL_PINS])();
+
+  std::vector<std::pair<std::string, void (*)(const char *, const char *)>> subscriptions;
+  std::map<std::string, int (*)(String)> functions;
+}
+
+// Called by the host TwoWire with the modeled bus time of each transaction
+void hostClockAdvanceMicros(uint64_t us) {
+  sim::advance(us);
+}
+
+unsigned long millis() {
+  return (unsigned long)((sim::now() - sim::bootTime()) / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(sim::now() - sim::bootTime());
+}
+
+void delay(unsigned long ms) {
+  sim::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  sim::advance(us);
+}
+
+static void logv(const char *level, const char *fmt, va_list ap) {
+  if (!sim::verbose) return;
+  time_t t = sim::epoch();
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  printf("%04d-%02d-%02d %02d:%02d:%02d %010lu [app] %s: ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, millis(), level);
+  vprintf(fmt, ap);
+  printf("\n");
+}
+
+void Logger::trace(const char *fmt, ...) const {
+  va_list ap;
+  va_start(ap, fmt);
+  logv("TRACE", fmt, ap);
+  va_end(ap);
+}
+
+void Logger::info(const char *fmt, ...) const {
+  va_list ap;
+  va_start(ap, fmt);
+  logv("INFO", fmt, ap);
+  va_end(ap);
+}
+
+void Logger::warn(const char *fmt, ...) const {
+  va_list ap;
+  va_start(ap, fmt);
+  logv("WARN", fmt, ap);
+  va_end(ap);
+}
+
+void Logger::error(const char *fmt, ...) const {
+  va_list ap;
+  va_start(ap, fmt);
+  logv("ERROR", fmt, ap);
+  va_end(ap);
+}
+
+void String::toCharArray(char *buf, unsigned bufSize) const {
+  if (!bufSize) return;
+  strncpy(buf, s.c_str(), bufSize - 1);
+  buf[bufSize - 1] = 0;
+}
+
+// Pins
+void pinMode(int pin, PinMode mode) {
+  pinModes[pin] = mode;
+}
+
+void digitalWrite(int pin, int value) {
+  pinLevels[pin] = value ? HIGH : LOW;
+  sim::onPinWrite(pin, pinLevels[pin]);
+}
+
+int digitalRead(int pin) {
+  return (pinModes[pin] == OUTPUT) ? pinLevels[pin] : sim::inputLevel(pin);
+}
+
+int analogRead(int pin) {
+  sim::advance(ADC_MICROS);
+  return sim::analogLevel(pin);
+}
+
+bool attachInterrupt(int pin, void (*handler)(), InterruptMode mode) {
+  interruptHandlers[pin] = handler;
+  return true;
+}
+
+void detachInterrupt(int pin) {
+  interruptHandlers[pin] = nullptr;
+}
+
+long random(long max) {
+  static uint64_t state = 0;
+  if (!state) state = sim::now() | 1;                                   // Each boot is a fresh process - seeded from the virtual clock
+  state ^= state << 13;                                                 // xorshift64
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (max > 0) ? (long)(state % (uint64_t)max) : 0;
+}
+
+long random(long min, long max) {
+  return (max > min) ? min + random(max - min) : min;
+}
+
+// Timer
+void Timer::start() {
+  stop();
+  active = true;
+  event = sim::schedule(sim::now() + (uint64_t)period * 1000, sim::SYSTEM, [this]() { fire(); });
+}
+
+void Timer::stop() {
+  if (!active) return;
+  sim::cancel(event);
+  active = false;
+}
+
+void Timer::fire() {
+  if (oneShot) active = false;
+  else event = sim::schedule(sim::now() + (uint64_t)period * 1000, sim::SYSTEM, [this]() { fire(); });
+  callback();
+}
+
+// Time
+void TimeClass::beginDST() {
+  if (!sim::stats->dstApplied) sim::stats->dstChanges++;
+  dst = sim::stats->dstApplied = true;
+}
+
+void TimeClass::endDST() {
+  if (sim::stats->dstApplied) sim::stats->dstChanges++;
+  dst = sim::stats->dstApplied = false;
+}
+
+struct tm TimeClass::field(time_t t) {
+  t += localOffset();
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  return tm;
+}
+
+String TimeClass::timeStr(time_t t) {
+  if (!t) t = now();
+  t += localOffset();
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char buf[32];
+  strftime(buf, sizeof(buf), "%a %b %e %H:%M:%S %Y", &tm);
+  return String(buf);
+}
+
+// Cellular - registered CELLULAR_CONNECT_MICROS after it was asked to connect or coverage came back, whichever is later
+void CellularClass::on() {
+  if (poweredAt == UINT64_MAX) poweredAt = sim::now();
+}
+
+void CellularClass::off() {
+  wanted = false;
+  poweredAt = UINT64_MAX;
+}
+
+bool CellularClass::isOn() {
+  return poweredAt != UINT64_MAX && sim::now() >= poweredAt + MODEM_ON_MICROS;
+}
+
+void CellularClass::connect() {
+  on();                                                                 // Device OS powers the modem up if it has to
+  if (!wanted) requestedAt = sim::now();
+  wanted = true;
+}
+
+void CellularClass::disconnect() {
+  wanted = false;
+}
+
+uint64_t CellularClass::readyAt() {
+  if (!wanted) return UINT64_MAX;
+  uint64_t since = sim::coverageSince(sim::now());
+  if (since == UINT64_MAX) return UINT64_MAX;
+  return ((since > requestedAt) ? since : requestedAt) + CELLULAR_CONNECT_MICROS;
+}
+
+bool CellularClass::ready() {
+  return sim::now() >= readyAt();
+}
+
+// Cloud
+void ParticleClass::connect() {
+  Cellular.connect();
+  if (!wanted) requestedAt = sim::now();
+  wanted = true;
+}
+
+void ParticleClass::disconnect() {
+  wanted = false;
+}
+
+bool ParticleClass::connected() {
+  if (!wanted) return false;
+  uint64_t cellular = Cellular.readyAt();
+  if (cellular == UINT64_MAX) return false;
+  return sim::now() >= ((cellular > requestedAt) ? cellular : requestedAt) + CLOUD_CONNECT_MICROS;
+}
+
+bool ParticleClass::publish(const char *name, const char *data, int flags) {
+  sim::stats->publishes++;
+  if (!connected()) {
+    sim::stats->publishesOffline++;
+    return false;
+  }
+  sim::onPublish(name, data);
+  return true;
+}
+
+bool ParticleClass::subscribe(const char *prefix, void (*handler)(const char *, const char *), SubscribeScope scope) {
+  subscriptions.push_back(std::make_pair(std::string(prefix), handler));
+  return true;
+}
+
+bool ParticleClass::function(const char *name, int (*handler)(String)) {
+  functions[name] = handler;
+  return true;
+}
+
+// System
+void SystemClass::reset() {
+  sim::reset(RESET_REASON_USER, 0);
+}
+
+void SystemClass::sleep(SleepMode mode, long seconds) {
+  if (mode == SLEEP_MODE_DEEP) sim::reset(RESET_REASON_POWER_MANAGEMENT, (uint64_t)seconds * 1000000);
+  delay(seconds * 1000);
+}
+
+bool SystemClass::waitCondition(std::function<bool()> condition, unsigned long timeoutMs) {
+  uint64_t start = sim::now();
+  while (!condition()) {
+    if (timeoutMs && sim::now() - start >= (uint64_t)timeoutMs * 1000) return false;
+    sim::advance(WAIT_STEP_MICROS);
+  }
+  return true;
+}
+
+// Device side of the simulator interface
+namespace sim {
+  int outputLevel(int pin) {
+    return pinLevels[pin];
+  }
+
+  void raiseInterrupt(int pin) {
+    if (interruptHandlers[pin]) interruptHandlers[pin]();
+  }
+
+  bool callFunction(const char *name, const char *arg, int *result) {
+    auto it = functions.find(name);
+    if (it == functions.end()) return false;
+    int value = it->second(String(arg));
+    if (result) *result = value;
+    return true;
+  }
+
+  void deliverEvent(const char *event, const char *data) {
+    for (auto &subscription : subscriptions) {
+      if (strncmp(event, subscription.first.c_str(), subscription.first.length()) == 0) subscription.second(event, data);
+    }
+  }
+
+  const char *deviceID() {
+    return "e00fce68a1b2c3d4e5f60718";
+  }
+}
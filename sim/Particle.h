@@ -0,0 +1,255 @@
+#ifndef __PARTICLE_SIM_H
+#define __PARTICLE_SIM_H
+
+// Host-side (Linux) stand-in for the parts of Particle.h used by Cellular-Control.ino, so the whole
+// firmware can run against a simulated site at accelerated time. Not used on-device.
+//
+// Everything is driven by the discrete-event virtual clock in Sim.h - millis(), Time, Timer, delay()
+// and waitFor() only move when the simulator moves the clock. The FRAM is the simulated part from
+// lib/MB85RC256V-FRAM-RK/host on the host TwoWire bus. See sim/sim-main.cpp for the build command.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include "HostWire.h"
+#include "Sim.h"
+
+#define PARTICLE_HOST_SIM 1
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+#define STARTUP(code) namespace { struct SimStartup { SimStartup() { code; } } simStartup; }
+
+#define WITH_LOCK(lock) for (std::unique_lock<std::remove_reference<decltype(lock)>::type> __lock##lock((lock)); __lock##lock; __lock##lock.unlock())
+
+// Same expansion as Device OS, so member functions like Particle.connected work as conditions
+#define waitFor(condition, timeout) System.waitCondition([]{ return (condition)(); }, (timeout))
+#define waitUntil(condition) System.waitCondition([]{ return (condition)(); })
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+enum LogLevel { LOG_LEVEL_ALL = 1, LOG_LEVEL_TRACE = 1, LOG_LEVEL_INFO = 30, LOG_LEVEL_WARN = 40, LOG_LEVEL_ERROR = 50, LOG_LEVEL_NONE = 70 };
+
+class Logger {
+public:
+  void trace(const char *fmt, ...) const;
+  void info(const char *fmt, ...) const;
+  void warn(const char *fmt, ...) const;
+  void error(const char *fmt, ...) const;
+};
+
+extern const Logger Log;
+
+class SerialLogHandler {
+public:
+  SerialLogHandler(LogLevel level = LOG_LEVEL_INFO) {};
+};
+
+class String {
+public:
+  String() {};
+  String(const char *s) : s(s ? s : "") {};
+  const char *c_str() const { return s.c_str(); };
+  operator const char *() const { return s.c_str(); };
+  bool operator==(const char *other) const { return s == other; };
+  unsigned length() const { return (unsigned)s.length(); };
+  void toCharArray(char *buf, unsigned bufSize) const;
+
+protected:
+  std::string s;
+};
+
+// Pins
+enum {
+  D0 = 0, D1, D2, D3, D4, D5, D6, D7,
+  A0 = 10, A1, A2, A3, A4, A5, A6, A7,
+  B0 = 24, B1, B2, B3, B4, B5,
+  C0 = 30, C1, C2, C3, C4, C5,
+  TOTAL_PINS = 36
+};
+
+enum PinMode { INPUT, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN };
+enum InterruptMode { CHANGE, RISING, FALLING };
+const int LOW = 0;
+const int HIGH = 1;
+
+void pinMode(int pin, PinMode mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int analogRead(int pin);
+inline void digitalWriteFast(int pin, int value) { digitalWrite(pin, value); };
+inline void pinSetFast(int pin) { digitalWrite(pin, HIGH); };
+inline void pinResetFast(int pin) { digitalWrite(pin, LOW); };
+inline int pinReadFast(int pin) { return digitalRead(pin); };
+bool attachInterrupt(int pin, void (*handler)(), InterruptMode mode);
+void detachInterrupt(int pin);
+
+long random(long max);                                                  // 0 to max - 1, repeatable for a given boot time
+long random(long min, long max);
+inline long map(long value, long fromStart, long fromEnd, long toStart, long toEnd) {
+  return (value - fromStart) * (toEnd - toStart) / (fromEnd - fromStart) + toStart;
+};
+
+// Software timers run when the virtual clock reaches them, like the timer thread on the device
+class Timer {
+public:
+  Timer(unsigned period, std::function<void()> callback, bool oneShot = false) : period(period), callback(callback), oneShot(oneShot) {};
+  ~Timer() { stop(); };
+
+  void start();
+  void stop();
+  void reset() { start(); };
+  void changePeriod(unsigned period) { this->period = period; start(); };
+  bool isActive() const { return active; };
+
+protected:
+  void fire();
+
+  unsigned period;
+  std::function<void()> callback;
+  bool oneShot;
+  bool active = false;
+  sim::EventId event;
+};
+
+class TimeClass {
+public:
+  time_t now() { return sim::epoch(); };
+  time_t local() { return now() + localOffset(); };
+  void zone(float offset) { zoneOffset = offset; };
+  float zone() const { return zoneOffset; };
+  void setDSTOffset(float offset) { dstOffset = offset; };
+  void beginDST();
+  void endDST();
+  bool isDST() const { return dst; };
+  bool isValid() const { return true; };
+
+  int hour() { return field(now()).tm_hour; };
+  int hour(time_t t) { return field(t).tm_hour; };
+  int minute() { return field(now()).tm_min; };
+  int second() { return field(now()).tm_sec; };
+  int day() { return field(now()).tm_mday; };
+  int weekday() { return field(now()).tm_wday + 1; };                  // 1 is Sunday
+  int month() { return field(now()).tm_mon + 1; };
+  int year() { return field(now()).tm_year + 1900; };
+
+  String timeStr(time_t t = 0);
+
+protected:
+  time_t localOffset() const { return (time_t)((zoneOffset + (dst ? dstOffset : 0)) * 3600); };
+  struct tm field(time_t t);                                            // Broken-down local time
+
+  float zoneOffset = 0;
+  float dstOffset = 1;
+  bool dst = false;
+};
+
+extern TimeClass Time;
+
+enum NetAccessTechnology { NET_ACCESS_TECHNOLOGY_UNKNOWN = 0, NET_ACCESS_TECHNOLOGY_GSM = 3, NET_ACCESS_TECHNOLOGY_UMTS = 4 };
+
+class CellularSignal {
+public:
+  int getAccessTechnology() const { return NET_ACCESS_TECHNOLOGY_UMTS; };
+  float getStrength() const { return 60.0; };
+  float getStrengthValue() const { return -85.0; };
+  float getQuality() const { return 50.0; };
+  float getQualityValue() const { return -10.0; };
+};
+
+class CellularClass {
+public:
+  static const uint64_t RSSI_MICROS = 300000;
+
+  void on();
+  void off();
+  bool isOn();
+  void connect();
+  void disconnect();
+  bool ready();
+  bool connecting() { return wanted && !ready(); };
+  CellularSignal RSSI() { sim::advance(RSSI_MICROS); return CellularSignal(); };  // An AT command round trip to the modem
+
+  uint64_t readyAt();                                                   // When the modem is, or will be, registered - UINT64_MAX if not
+
+protected:
+  bool wanted = false;
+  uint64_t requestedAt = 0;
+  uint64_t poweredAt = UINT64_MAX;                                      // When the modem was turned on, UINT64_MAX while off
+};
+
+extern CellularClass Cellular;
+
+enum PublishFlag { PUBLIC = 0, PRIVATE = 1, NO_ACK = 2, WITH_ACK = 8 };
+enum SubscribeScope { ALL_DEVICES, MY_DEVICES };
+
+class ParticleClass {
+public:
+  void connect();
+  void disconnect();
+  bool connected();
+  void process() { sim::runApplicationEvents(); };
+  bool publish(const char *name, const char *data, int flags = PUBLIC);
+  bool subscribe(const char *prefix, void (*handler)(const char *, const char *), SubscribeScope scope = ALL_DEVICES);
+  template <typename T> bool variable(const char *name, T &) { return true; };
+  bool function(const char *name, int (*handler)(String));
+  void syncTime() {};
+  bool syncTimeDone() { return true; };
+
+protected:
+  bool wanted = false;
+  uint64_t requestedAt = 0;
+};
+
+extern ParticleClass Particle;
+
+class FuelGauge {
+public:
+  float getSoC() { return sim::batterySoC(); };
+  float getVCell() { return 3.6 + sim::batterySoC() / 200.0; };
+};
+
+class PMIC {
+public:
+  PMIC() {};
+};
+
+enum ResetReason {
+  RESET_REASON_NONE = 0, RESET_REASON_UNKNOWN = 10, RESET_REASON_PIN_RESET = 20, RESET_REASON_POWER_MANAGEMENT = 30,
+  RESET_REASON_POWER_DOWN = 40, RESET_REASON_POWER_BROWNOUT = 50, RESET_REASON_WATCHDOG = 60, RESET_REASON_USER = 140
+};
+enum SleepMode { SLEEP_MODE_WLAN, SLEEP_MODE_DEEP };
+enum SystemFeature { FEATURE_RESET_INFO, FEATURE_RETAINED_MEMORY };
+enum PowerSource { POWER_SOURCE_UNKNOWN = 0, POWER_SOURCE_VIN = 1, POWER_SOURCE_USB_HOST = 2, POWER_SOURCE_BATTERY = 5 };
+
+class SystemClass {
+public:
+  int resetReason() const { return reason; };
+  void reset();
+  void sleep(SleepMode mode, long seconds);
+  int powerSource() const { return POWER_SOURCE_VIN; };
+  String deviceID() { return String(sim::deviceID()); };
+  void enableFeature(SystemFeature) {};
+  bool waitCondition(std::function<bool()> condition, unsigned long timeoutMs = 0);
+
+  int reason = RESET_REASON_NONE;                                       // Set by the simulator at each boot
+};
+
+extern SystemClass System;
+
+#endif /* __PARTICLE_SIM_H */
@@ -0,0 +1,94 @@
+#include "Sim.h"
+
+#include <map>
+
+namespace sim {
+  Stats *stats = nullptr;
+  time_t startEpoch = 0;
+  bool verbose = false;
+
+  namespace {
+    struct Event {
+      Context context;
+      Action action;
+    };
+
+    uint64_t clock = 0;
+    uint64_t bootAt = 0;
+    uint64_t nextSequence = 0;
+    uint64_t systemRuns = 0;
+    std::map<EventId, Event> events;
+
+    // First event of a context that is due by the given time, or events.end()
+    std::map<EventId, Event>::iterator firstDue(Context context, uint64_t by) {
+      for (auto it = events.begin(); it != events.end() && it->first.first <= by; ++it) {
+        if (it->second.context == context) return it;
+      }
+      return events.end();
+    }
+  }
+
+  void begin(uint64_t clockMicros) {
+    clock = clockMicros;
+    bootAt = clockMicros;
+    events.clear();
+  }
+
+  uint64_t now() {
+    return clock;
+  }
+
+  uint64_t bootTime() {
+    return bootAt;
+  }
+
+  time_t epoch() {
+    return startEpoch + (time_t)(clock / 1000000);
+  }
+
+  EventId schedule(uint64_t at, Context context, Action action) {
+    EventId id(at, nextSequence++);
+    events[id] = Event{context, action};
+    return id;
+  }
+
+  void cancel(EventId id) {
+    events.erase(id);
+  }
+
+  void advance(uint64_t us) {
+    uint64_t target = clock + us;
+    for (;;) {
+      auto it = firstDue(SYSTEM, target);
+      if (it == events.end()) break;
+      if (it->first.first > clock) clock = it->first.first;
+      Action action = it->second.action;
+      events.erase(it);
+      systemRuns++;
+      action();                                                         // May advance the clock itself, for example with FRAM traffic
+    }
+    if (target > clock) clock = target;
+  }
+
+  uint64_t nextEvent() {
+    return events.empty() ? UINT64_MAX : events.begin()->first.first;
+  }
+
+  uint64_t systemEventsRun() {
+    return systemRuns;
+  }
+
+  bool applicationEventDue() {
+    return firstDue(APPLICATION, clock) != events.end();
+  }
+
+  void runApplicationEvents() {
+    for (;;) {
+      auto it = firstDue(APPLICATION, clock);
+      if (it == events.end()) break;
+      Action action = it->second.action;
+      events.erase(it);
+      action();
+    }
+  }
+}
@@ -0,0 +1,108 @@
+#ifndef __SIM_H
+#define __SIM_H
+
+// Host firmware simulator - the virtual clock and event queue, and the hooks between the
+// Particle API stand-ins (sim/Particle.cpp) and the scenario that models the site (sim/sim-main.cpp)
+
+#include <stdint.h>
+#include <time.h>
+#include <functional>
+#include <utility>
+
+namespace sim {
+  typedef std::function<void()> Action;
+  typedef std::pair<uint64_t, uint64_t> EventId;                        // Time and sequence - unique and ordered
+
+  enum Context {
+    SYSTEM,                                                             // Runs as soon as the clock reaches it - software timers, interrupts, the radio
+    APPLICATION                                                         // Runs on the application thread - between loop() calls or in Particle.process()
+  };
+
+  // Counters kept across resets - they live in memory shared by every boot
+  struct Stats {
+    uint64_t loops;                                                     // loop() calls
+    uint64_t maxLoopMicros;                                             // Longest single loop() call in virtual time
+    uint64_t slowLoops;                                                 // loop() calls that took 100 ms or more of virtual time
+    uint32_t boots;
+    uint32_t resetsPin;                                                 // Watchdog - the TPL5010 pulls the reset pin
+    uint32_t resetsUser;                                                // System.reset()
+    uint32_t resetsSleep;                                               // Wake from deep sleep
+    uint32_t resetsPowerCycle;                                          // hardResetPin
+    uint32_t publishes;
+    uint32_t publishesOffline;                                          // Particle.publish while not connected - lost
+    uint64_t coveredMicros;                                             // Time with cellular coverage
+    uint64_t connectedMicros;                                           // Time with coverage and a cloud connection
+    struct {
+      char name[32];
+      uint32_t count;
+    } byName[24];
+    uint32_t reportsSent;                                               // Reports in Monitoring_Event publishes
+    uint32_t reportPublishes;                                           // Monitoring_Event publishes - fewer than reports once they are batched
+    uint64_t reportBytes;                                               // Their data - what the cellular plan charges for
+    uint32_t windowOnlyPumping;                                         // Reports with pump current in the window but none when taken
+    int16_t windowAmpsMax;                                              // Tenths
+    uint32_t reportDeltas;                                              // Publishes that were a ReportCodec delta
+    uint32_t reportsUndecoded;                                          // Neither JSON nor a ReportCodec record
+    uint32_t hookResponses;                                             // Webhook responses delivered to the device
+    uint32_t hookNoResponse;                                            // Webhook responses that never came
+    uint64_t reportDelayTotal;                                          // Report timestamp to Monitoring_Event publish
+    uint64_t reportDelayMax;
+    uint64_t backlogGapTotal;                                           // Between back to back Monitoring_Event publishes of late reports
+    uint32_t backlogGaps;
+    uint32_t pumpCommands;
+    uint32_t pumpCommandsMissed;                                        // Function calls while the device was offline
+    uint32_t pumpStarts;
+    uint32_t pumpStops;
+    uint32_t failsafeStops;                                             // Pump turned off by the firmware's failsafe rather than a command
+    uint32_t pumpResets;                                                // Device reset while the pump was running - the relay drops out
+    uint32_t pumpResumes;                                               // Pump started again after a reset without a new command
+    uint64_t longestRun;                                                // Latest relay off after an on command, microseconds
+    uint64_t resumeLatencyMax;                                          // Boot to relay on for resumed runs
+    uint64_t relayLatencyTotal;                                         // PumpCalled function call to pumpControlPin write
+    uint64_t relayLatencyMax;
+    uint32_t relayLatencyCount;
+    uint32_t dstChanges;                                                // The local offset moving - not the firmware putting DST back after a boot
+    bool dstApplied;                                                    // What the firmware last set - a boot forgets it, like the device
+    uint32_t powerDips;                                                 // Control power lost for less than a second
+    uint32_t lowLevelPeriods;
+    uint32_t powerAlertReports;                                         // Monitoring_Event with the control power bit set
+    uint32_t lowLevelAlertReports;
+  };
+
+  extern Stats *stats;
+  extern time_t startEpoch;                                             // Unix time when the simulation starts
+  extern bool verbose;                                                  // Print the firmware's log messages
+
+  // Clock
+  void begin(uint64_t clockMicros);                                     // Starts a boot at this time - millis() counts from here
+  uint64_t now();                                                       // Virtual microseconds since the simulation started - keeps counting across resets
+  uint64_t bootTime();
+  time_t epoch();                                                       // Unix time now
+
+  // Events
+  EventId schedule(uint64_t at, Context context, Action action);
+  void cancel(EventId id);
+  void advance(uint64_t us);                                            // Moves the clock, running SYSTEM events that come due on the way
+  uint64_t nextEvent();                                                 // Time of the next event of either kind, UINT64_MAX if there are none
+  uint64_t systemEventsRun();                                           // Count of SYSTEM events run so far this boot
+  bool applicationEventDue();
+  void runApplicationEvents();
+
+  // Device side, implemented in sim/Particle.cpp
+  int outputLevel(int pin);                                             // The level last written to a pin
+  void raiseInterrupt(int pin);                                         // Calls the handler from attachInterrupt()
+  bool callFunction(const char *name, const char *arg, int *result);    // A Particle.function call from the cloud
+  void deliverEvent(const char *event, const char *data);               // An event for Particle.subscribe() handlers
+  const char *deviceID();
+
+  // Site, implemented by the scenario
+  void onPinWrite(int pin, int value);
+  int inputLevel(int pin);                                              // digitalRead() of a pin that is not an output
+  int analogLevel(int pin);                                             // 0 - 4095
+  float batterySoC();
+  void onPublish(const char *name, const char *data);                   // Only called for publishes that reach the cloud
+  uint64_t coverageSince(uint64_t at);                                  // Start of the cellular coverage period containing at, UINT64_MAX if there is none
+  [[noreturn]] void reset(int reason, uint64_t offMicros);              // Ends this boot - the next starts offMicros later
+}
+
+#endif /* __SIM_H */
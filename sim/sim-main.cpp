@@ -0,0 +1,528 @@
+// Host entry point for the firmware simulator. Runs src/Cellular-Control.ino (through the generated
+// src/Cellular-Control.cpp) against a model of a pump site on a virtual clock, so months of hourly
+// reports, DST changes, input glitches and pump failsafe expirations take seconds. Build and run from the top of the repo:
+//
+//   g++ -std=c++11 -O2 -Isim -Isrc -Ilib/MB85RC256V-FRAM-RK/src -Ilib/MB85RC256V-FRAM-RK/host sim/*.cpp src/*.cpp lib/MB85RC256V-FRAM-RK/src/*.cpp lib/MB85RC256V-FRAM-RK/host/HostWire.cpp lib/MB85RC256V-FRAM-RK/host/FramSim.cpp -o cellular-sim
+//   ./cellular-sim [-d days] [-f hookFailPercent] [-o outagePercent] [-s seed] [-t stepMs] [-r format] [-p] [-v]
+//
+// Each boot runs in a forked child so the firmware's globals start fresh after a reset, the same as
+// on the device. The FRAM contents, the clock and the statistics live in shared memory and carry over.
+// The site model is deterministic for a given seed, so runs are repeatable.
+
+#include "Particle.h"
+#include "FramSim.h"
+#include "ReportCodec.h"
+
+#include <chrono>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+namespace {
+  const size_t FRAM_SIZE = 8192;                                        // MB85RC64
+  const uint64_t SECOND = 1000000;
+  const uint64_t MINUTE = 60 * SECOND;
+  const uint64_t HOUR = 60 * MINUTE;
+  const uint64_t DAY = 24 * HOUR;
+
+  // Site wiring - the same pins as Cellular-Control.ino
+  const int tmp36Pin = A0;
+  const int pumpCurrentPin = A2;
+  const int pumpControlPin = A4;
+  const int wakeUpPin = A7;
+  const int controlPowerPin = B1;
+  const int lowLevelPin = B3;
+  const int hardResetPin = D4;
+  const int donePin = D6;
+
+  const uint64_t WATCHDOG_PERIOD = 60 * MINUTE;                         // TPL5010 wake interval - reset if not petted by the next one
+  const uint64_t HOOK_LATENCY = 2 * SECOND;                             // Publish to webhook response - up to twice this
+  const uint64_t PUMP_RUN = 45 * MINUTE;                                // How long the storage facility calls for water
+  const uint64_t PUMP_RESET_AT = 20 * MINUTE;                           // Twice a week the device resets this far into a session
+  const size_t RIPPLE_PERIOD = 8333;                                    // Microseconds in one cycle of 120 Hz ripple
+  const int SITE_UTC_OFFSET = -5;                                       // Pump sessions are scheduled at 06:00 and 18:00 standard time
+  const uint64_t POWER_DIP_AT = 3 * HOUR + 17 * MINUTE;                 // Control power drops out for a moment at 03:17 every day
+  const uint64_t POWER_DIP = 400000;
+  const uint64_t BUSY_DIP_AT = 3 * HOUR + 100000;                       // And again while the 03:00 report is being taken - loop() is busy
+  const uint64_t BUSY_DIP = 150000;
+  const uint64_t LOW_LEVEL_AT = 12 * HOUR;                              // The level switch opens at noon one day a week
+  const uint64_t LOW_LEVEL_RUN = 20 * MINUTE;
+  const uint64_t BOUNCE = 2000;                                         // Level switch contact bounce - 4 extra edges 2 ms apart each way
+  const int BOUNCES = 4;
+
+  struct Config {
+    int days = 365;
+    int hookFailPercent = 0;                                            // Webhook responses that never arrive
+    int outagePercent = 0;                                              // Hours with no cellular coverage
+    uint64_t seed = 1;
+    uint64_t stepMicros = SECOND;                                       // Largest clock step between loop() calls
+    bool tracePublishes = false;
+    const char *reportFormat = nullptr;                                 // Provisioned with Report-Format - json, binary or delta
+  } config;
+
+  // Everything that has to survive a reset
+  struct Shared {
+    uint64_t clock;
+    int resetReason;
+    bool done;
+    uint8_t fram[FRAM_SIZE];
+    uint64_t pumpOnAt;                                                  // Relay on since, 0 when off
+    uint64_t pumpCalledAt;                                              // Last on command, 0 after an off command
+    uint64_t lastReportAt;                                              // Last Monitoring_Event publish
+    bool provisioned;
+    MonitoringReport webhookReports[256];                               // What the webhook has received, by seq modulo 256 - deltas are applied to these
+    sim::Stats stats;
+  } *shared;
+
+  FramSim *framSim;
+  bool petted;
+  uint64_t pumpCommandAt;                                               // Last PumpCalled call not yet seen at the relay
+
+  uint64_t hash(uint64_t x) {                                           // splitmix64 - a fixed function of the seed and x
+    x += config.seed * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  bool outageHour(uint64_t hour) {
+    return config.outagePercent && hash(hour) % 100 < (uint64_t)config.outagePercent;
+  }
+
+  [[noreturn]] void endBoot() {
+    memcpy(shared->fram, framSim->memory(), FRAM_SIZE);
+    shared->clock = sim::now();
+    fflush(stdout);
+    _exit(0);
+  }
+
+  [[noreturn]] void finish() {
+    shared->done = true;
+    endBoot();
+  }
+
+  void provision() {                                                    // The installer sets the time zone once - waiting for coverage if need be
+    if (!Particle.connected()) {
+      sim::schedule(sim::now() + 60 * SECOND, sim::APPLICATION, provision);
+      return;
+    }
+    sim::callFunction("Set-Timezone", "-5", nullptr);
+    if (config.reportFormat) sim::callFunction("Report-Format", config.reportFormat, nullptr);
+    shared->provisioned = true;
+  }
+
+  void watchdogTick() {
+    if (!petted) sim::reset(RESET_REASON_PIN_RESET, 0);
+    petted = false;
+    sim::raiseInterrupt(wakeUpPin);                                     // WAKE pulse - the firmware has until the next tick to pet
+    sim::schedule(sim::now() + WATCHDOG_PERIOD, sim::SYSTEM, watchdogTick);
+  }
+
+  // Local standard time days - shifted by a day so the first hours of the run do not go negative
+  uint64_t localDay(uint64_t t) {
+    return (t + DAY + SITE_UTC_OFFSET * HOUR) / DAY;
+  }
+
+  uint64_t localDayStart(uint64_t day) {
+    return day * DAY - DAY - SITE_UTC_OFFSET * HOUR;
+  }
+
+  bool lowLevelDay(uint64_t day) {
+    return day % 7 == 3;
+  }
+
+  int bouncedLow(uint64_t t, uint64_t start, uint64_t length) {         // LOW from start for length, with contact bounce at both ends
+    if (t < start || t >= start + length + BOUNCES * BOUNCE) return HIGH;
+    if (t < start + BOUNCES * BOUNCE) return ((t - start) / BOUNCE) % 2 ? HIGH : LOW;
+    if (t >= start + length) return ((t - start - length) / BOUNCE) % 2 ? LOW : HIGH;
+    return LOW;
+  }
+
+  void inputEdge(int pin, uint64_t at) {
+    if (at >= sim::now()) sim::schedule(at, sim::SYSTEM, [pin]() { sim::raiseInterrupt(pin); });
+  }
+
+  void scheduleInputs(uint64_t day) {                                   // Interrupts for every edge of the day, then the next day
+    uint64_t start = localDayStart(day);
+    inputEdge(controlPowerPin, start + POWER_DIP_AT);
+    inputEdge(controlPowerPin, start + POWER_DIP_AT + POWER_DIP);
+    inputEdge(controlPowerPin, start + BUSY_DIP_AT);
+    inputEdge(controlPowerPin, start + BUSY_DIP_AT + BUSY_DIP);
+    for (uint64_t at : {start + POWER_DIP_AT, start + BUSY_DIP_AT}) {
+      if (at >= sim::now()) sim::schedule(at, sim::SYSTEM, []() { shared->stats.powerDips++; });
+    }
+    if (lowLevelDay(day)) {
+      for (int i = 0; i <= BOUNCES; i++) {
+        inputEdge(lowLevelPin, start + LOW_LEVEL_AT + i * BOUNCE);
+        inputEdge(lowLevelPin, start + LOW_LEVEL_AT + LOW_LEVEL_RUN + i * BOUNCE);
+      }
+      if (start + LOW_LEVEL_AT >= sim::now()) sim::schedule(start + LOW_LEVEL_AT, sim::SYSTEM, []() { shared->stats.lowLevelPeriods++; });
+    }
+    sim::schedule(localDayStart(day + 1), sim::SYSTEM, [day]() { scheduleInputs(day + 1); });
+  }
+
+  void pumpCommand(const char *arg) {
+    shared->stats.pumpCommands++;
+    if (!Particle.connected()) {
+      shared->stats.pumpCommandsMissed++;
+      return;
+    }
+    pumpCommandAt = sim::now();
+    shared->pumpCalledAt = (arg[0] == '1') ? sim::now() : 0;
+    sim::callFunction("PumpCalled", arg, nullptr);
+  }
+
+  // Two sessions a day. On the last session of each week the off command never comes so pumpBackupTimer has to stop the pump.
+  // Commands come in up to a minute after the hour. They are SYSTEM events, so some land mid loop() - harsher than Device OS,
+  // which runs Particle.function calls between loop() passes, and the way a Timer or an ISR would post to the mailbox.
+  uint64_t sessionStart(uint64_t session) {
+    uint64_t firstSession = 6 * HOUR - SITE_UTC_OFFSET * HOUR;         // 06:00 local on the first day, in simulation time
+    return firstSession + session * 12 * HOUR + hash(session) % MINUTE;
+  }
+
+  bool sessionHasOff(uint64_t session) {
+    return session % 14 != 13;
+  }
+
+  bool sessionHasReset(uint64_t session) {                              // One normal session and the failsafe session each week
+    return session % 7 == 6;
+  }
+
+  void scheduleSession(uint64_t session) {
+    uint64_t start = sessionStart(session);
+    if (start >= sim::now()) {
+      sim::schedule(start, sim::SYSTEM, [session]() {
+        pumpCommand("1");
+        scheduleSession(session + 1);
+      });
+    }
+    else scheduleSession(session + 1);
+    if (sessionHasOff(session) && start + PUMP_RUN >= sim::now()) {
+      sim::schedule(start + PUMP_RUN, sim::SYSTEM, []() { pumpCommand("0"); });
+    }
+    if (sessionHasReset(session) && start + PUMP_RESET_AT > sim::now()) {
+      sim::schedule(start + PUMP_RESET_AT, sim::SYSTEM, []() { sim::reset(RESET_REASON_PIN_RESET, 0); });
+    }
+  }
+
+  void runBoot() {
+    sim::begin(shared->clock);
+    sim::stats = &shared->stats;
+    shared->stats.boots++;
+    System.reason = shared->resetReason;
+
+    framSim = new FramSim(FRAM_SIZE, 0);
+    memcpy(framSim->memory(), shared->fram, FRAM_SIZE);
+    Wire.attach(framSim);
+
+    petted = true;
+    sim::schedule(sim::now() + WATCHDOG_PERIOD, sim::SYSTEM, watchdogTick);
+    sim::schedule((uint64_t)config.days * DAY, sim::SYSTEM, finish);
+
+    uint64_t now = sim::now();
+    scheduleSession((now > sessionStart(0)) ? (now - sessionStart(0)) / (12 * HOUR) : 0);
+    scheduleInputs(localDay(now));
+    if (!shared->provisioned) sim::schedule(now + 60 * SECOND, sim::APPLICATION, provision);
+
+    setup();
+    for (;;) {
+      sim::runApplicationEvents();
+      uint64_t start = sim::now();
+      bool covered = sim::coverageSince(start) != UINT64_MAX;
+      bool connected = covered && Particle.connected();
+      uint64_t systemEvents = sim::systemEventsRun();
+      loop();
+      uint64_t elapsed = sim::now() - start;
+      shared->stats.loops++;
+      if (elapsed > shared->stats.maxLoopMicros) shared->stats.maxLoopMicros = elapsed;
+      if (elapsed >= 100000) shared->stats.slowLoops++;
+      if (!sim::applicationEventDue() && sim::systemEventsRun() == systemEvents) {  // On the device the next pass starts right away - only step when nothing happened during this one
+        uint64_t next = sim::nextEvent();
+        uint64_t step = (next > sim::now() && next - sim::now() < config.stepMicros) ? next - sim::now() : config.stepMicros;
+        sim::advance(step);
+      }
+      if (covered) shared->stats.coveredMicros += sim::now() - start;   // Sampled once a pass - close enough at one second steps
+      if (connected) shared->stats.connectedMicros += sim::now() - start;
+    }
+  }
+
+  void countPublish(const char *name) {
+    for (auto &entry : shared->stats.byName) {
+      if (!entry.name[0]) strncpy(entry.name, name, sizeof(entry.name) - 1);
+      if (strcmp(entry.name, name) == 0) {
+        entry.count++;
+        return;
+      }
+    }
+  }
+
+  void printSummary(double wallSeconds) {
+    const sim::Stats &stats = shared->stats;
+    printf("Simulated %d days in %.2f s (%.0fx real time)\n", config.days, wallSeconds, config.days * 86400.0 / wallSeconds);
+    printf("loop() calls: %llu, longest %.1f ms, %llu took 100 ms or more\n", (unsigned long long)stats.loops, stats.maxLoopMicros / 1000.0, (unsigned long long)stats.slowLoops);
+    printf("Boots: %u - watchdog %u, System.reset %u, deep sleep %u, power cycle %u\n", stats.boots, stats.resetsPin, stats.resetsUser, stats.resetsSleep, stats.resetsPowerCycle);
+    printf("Publishes: %u, %u while offline\n", stats.publishes, stats.publishesOffline);
+    if (stats.coveredMicros) printf("Cloud: connected %.2f%% of the time there was coverage\n", 100.0 * stats.connectedMicros / stats.coveredMicros);
+    for (auto &entry : stats.byName) {
+      if (entry.name[0]) printf("  %-20s %u\n", entry.name, entry.count);
+    }
+    printf("Reports: %u sent, %u responses, %u not answered\n", stats.reportsSent, stats.hookResponses, stats.hookNoResponse);
+    if (stats.reportsSent) printf("Report data: %u publishes, %.1f bytes per report, %u deltas, %u could not be decoded\n", stats.reportPublishes, (double)stats.reportBytes / stats.reportsSent, stats.reportDeltas, stats.reportsUndecoded);
+    if (stats.reportsSent) printf("Report delay: mean %.1f s, longest %.1f min from taken to published\n", stats.reportDelayTotal / 1e6 / stats.reportsSent, stats.reportDelayMax / 60e6);
+    if (stats.windowAmpsMax) printf("Report windows: %u reports taken with the pump off saw it run, highest %.1f A\n", stats.windowOnlyPumping, stats.windowAmpsMax / 10.0);
+    if (stats.backlogGaps) printf("Backlog: %u reports sent right after another, %.2f s apart on average\n", stats.backlogGaps, stats.backlogGapTotal / 1e6 / stats.backlogGaps);
+    printf("Pump: %u commands (%u missed offline), %u starts, %u stops, %u by failsafe\n", stats.pumpCommands, stats.pumpCommandsMissed, stats.pumpStarts, stats.pumpStops, stats.failsafeStops);
+    printf("Pump resets: %u while running, %u resumed (at most %.1f ms after boot), longest run %.1f min after the on command\n", stats.pumpResets, stats.pumpResumes, stats.resumeLatencyMax / 1000.0, stats.longestRun / 60e6);
+    if (stats.relayLatencyCount) printf("Command to relay: mean %.1f ms, longest %.1f ms\n", stats.relayLatencyTotal / 1000.0 / stats.relayLatencyCount, stats.relayLatencyMax / 1000.0);
+    printf("DST changes: %u\n", stats.dstChanges);
+    printf("Inputs: %u power dips (%u reports with the power alert), %u low level periods (%u reports with the low level alert)\n", stats.powerDips, stats.powerAlertReports, stats.lowLevelPeriods, stats.lowLevelAlertReports);
+  }
+}
+
+// Site model
+namespace sim {
+  void onPinWrite(int pin, int value) {
+    if (pin == donePin && value) petted = true;
+    else if (pin == hardResetPin && value) reset(RESET_REASON_POWER_DOWN, 30 * SECOND);
+    else if (pin == pumpControlPin) {
+      bool commanded = pumpCommandAt != 0;
+      if (pumpCommandAt && (bool)value != (bool)shared->pumpOnAt) {
+        uint64_t latency = now() - pumpCommandAt;
+        shared->stats.relayLatencyTotal += latency;
+        shared->stats.relayLatencyCount++;
+        if (latency > shared->stats.relayLatencyMax) shared->stats.relayLatencyMax = latency;
+        pumpCommandAt = 0;
+      }
+      if (value && !shared->pumpOnAt) {
+        shared->stats.pumpStarts++;
+        if (!commanded) {                                               // No command waiting - picked up after a reset
+          shared->stats.pumpResumes++;
+          if (now() - bootTime() > shared->stats.resumeLatencyMax) shared->stats.resumeLatencyMax = now() - bootTime();
+        }
+        shared->pumpOnAt = now();
+      }
+      else if (!value && shared->pumpOnAt) {
+        shared->stats.pumpStops++;
+        uint64_t since = shared->pumpCalledAt ? shared->pumpCalledAt : shared->pumpOnAt;
+        if (now() - since >= PUMP_RUN + 30 * MINUTE) shared->stats.failsafeStops++;
+        if (now() - since > shared->stats.longestRun) shared->stats.longestRun = now() - since;
+        shared->pumpOnAt = 0;
+      }
+    }
+  }
+
+  int inputLevel(int pin) {
+    uint64_t t = now();
+    uint64_t day = localDay(t);
+    uint64_t start = localDayStart(day);
+    if (pin == controlPowerPin) {
+      if (t >= start + POWER_DIP_AT && t < start + POWER_DIP_AT + POWER_DIP) return LOW;
+      if (t >= start + BUSY_DIP_AT && t < start + BUSY_DIP_AT + BUSY_DIP) return LOW;
+      return HIGH;
+    }
+    if (pin == lowLevelPin) return lowLevelDay(day) ? bouncedLow(t, start + LOW_LEVEL_AT, LOW_LEVEL_RUN) : HIGH;
+    return (pin == wakeUpPin) ? LOW : HIGH;
+  }
+
+  int analogLevel(int pin) {
+    if (pin == pumpCurrentPin) {                                        // About 20 A when running, with the 120 Hz ripple of the rectified motor current
+      if (!outputLevel(pumpControlPin)) return 0;
+      static int16_t ripple[RIPPLE_PERIOD];                             // One 120 Hz period, 1 us per entry
+      if (!ripple[RIPPLE_PERIOD / 4]) {
+        for (size_t i = 0; i < RIPPLE_PERIOD; i++) ripple[i] = (int16_t)(300 * sin(2 * M_PI * i / RIPPLE_PERIOD));
+      }
+      return 2560 + ripple[now() % RIPPLE_PERIOD] + (int)(now() * 2654435761u >> 27) % 41 - 20;
+    }
+    if (pin == tmp36Pin) return 930;                                    // About 77F
+    return 0;
+  }
+
+  float batterySoC() {
+    return 85.0;
+  }
+
+  // The webhook stand-in - takes either format, as the real webhook has to while a fleet changes over
+  size_t decodeJson(const char *data, MonitoringReport &report) {
+    const char *keys[] = {"\"seq\":", "\"timestamp\":", "\"alertValue\":", "\"pumpAmps\":", "\"pumpMins\":", "\"battery\":", "\"temp\":", "\"resets\":", "\"signal\":", "\"quality\":"};
+    long long values[10];
+    for (size_t i = 0; i < 10; i++) {
+      const char *field = strstr(data, keys[i]);
+      if (!field) return 0;
+      values[i] = strtoll(field + strlen(keys[i]), NULL, 10);
+    }
+    report.seq = values[0];
+    report.timestamp = values[1] / 1000;                                // Milliseconds for Ubidots
+    report.alertValue = values[2];
+    report.pumpAmps = values[3];
+    report.pumpMins = values[4];
+    report.battery = values[5];
+    report.temp = values[6];
+    report.resets = values[7];
+    report.signal = values[8];
+    report.quality = values[9];
+    const char *windowKeys[] = {"\"ampsWindow\":{", "\"tempWindow\":{", "\"batteryWindow\":{"};
+    WindowSummary *windows[] = {&report.ampsWindow, &report.tempWindow, &report.batteryWindow};
+    const char *statKeys[] = {"\"min\":", "\"max\":", "\"mean\":", "\"stddev\":"};
+    for (size_t i = 0; i < 3; i++) {                                    // All four of each, inside its own braces
+      const char *window = strstr(data, windowKeys[i]);
+      if (!window) return 0;
+      const char *end = strchr(window, '}');
+      int16_t *stats[] = {&windows[i]->min, &windows[i]->max, &windows[i]->mean, &windows[i]->stddev};
+      for (size_t j = 0; j < 4; j++) {
+        const char *field = strstr(window, statKeys[j]);
+        if (!field || !end || field > end) return 0;
+        *stats[j] = (int16_t)strtol(field + strlen(statKeys[j]), NULL, 10);
+      }
+    }
+    return 1;
+  }
+
+  // Returns how many reports the publish holds - a binary one may be a batch, or a delta against one already received
+  size_t decodeReports(const char *data, MonitoringReport *reports, size_t maxReports) {
+    size_t count = 0;
+    if (data[0] == '{') count = decodeJson(data, reports[0]);
+    else {
+      uint8_t record[ReportCodec::Batch::maxLength(ReportCodec::MAX_PUBLISH + 1)];
+      size_t len = ReportCodec::unarmor(data, record, sizeof(record));
+      uint32_t baseSeq;
+      if (ReportCodec::deltaBase(record, len, baseSeq)) {
+        shared->stats.reportDeltas++;
+        const MonitoringReport &base = shared->webhookReports[baseSeq % 256];
+        if (base.seq == baseSeq && base.timestamp && ReportCodec::decodeDelta(record, len, base, reports[0]) == len) count = 1;
+      }
+      else count = ReportCodec::decodeBatch(record, len, reports, maxReports);
+    }
+    for (size_t i = 0; i < count; i++) shared->webhookReports[reports[i].seq % 256] = reports[i];
+    return count;
+  }
+
+  void onPublish(const char *name, const char *data) {
+    countPublish(name);
+    if (config.tracePublishes) {
+      time_t t = epoch();
+      struct tm tm;
+      gmtime_r(&t, &tm);
+      printf("%04d-%02d-%02d %02d:%02d:%02d UTC %s %s\n", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, name, data);
+    }
+    if (strcmp(name, "Monitoring_Event") != 0) return;
+
+    MonitoringReport reports[ReportCodec::MAX_BATCH] = {};
+    size_t count = decodeReports(data, reports, ReportCodec::MAX_BATCH);
+    if (!count) {
+      shared->stats.reportsUndecoded++;
+      return;
+    }
+    shared->stats.reportPublishes++;
+    shared->stats.reportBytes += strlen(data);
+    for (size_t i = 0; i < count; i++) {
+      const MonitoringReport &report = reports[i];
+      if (report.alertValue & 0b00000001) shared->stats.powerAlertReports++;
+      if (report.alertValue & 0b00000010) shared->stats.lowLevelAlertReports++;
+      if (report.ampsWindow.max > 0 && report.pumpAmps == 0) shared->stats.windowOnlyPumping++;
+      if (report.ampsWindow.max > shared->stats.windowAmpsMax) shared->stats.windowAmpsMax = report.ampsWindow.max;
+      shared->stats.reportsSent++;
+      uint64_t takenAt = (uint64_t)(report.timestamp - startEpoch) * SECOND;  // Taken to published - the backlog after an outage shows up here
+      uint64_t delay = (now() > takenAt) ? now() - takenAt : 0;
+      shared->stats.reportDelayTotal += delay;
+      if (delay > shared->stats.reportDelayMax) shared->stats.reportDelayMax = delay;
+      if (delay >= MINUTE && shared->lastReportAt && now() - shared->lastReportAt < MINUTE) {  // Backlog going out - how far apart
+        shared->stats.backlogGapTotal += now() - shared->lastReportAt;
+        shared->stats.backlogGaps++;
+      }
+      shared->lastReportAt = now();
+    }
+    if (hash(now()) % 100 < (uint64_t)config.hookFailPercent) {
+      shared->stats.hookNoResponse++;
+      return;
+    }
+    unsigned long seqValue = reports[0].seq;                            // A batch is answered by its first
+    schedule(now() + HOOK_LATENCY + hash(now() + 1) % HOOK_LATENCY, APPLICATION, [seqValue]() {  // Responses can overtake each other
+      shared->stats.hookResponses++;
+      char topic[80];
+      char response[24];
+      snprintf(topic, sizeof(topic), "%s/hook-response/Monitoring_Event/0", deviceID());
+      snprintf(response, sizeof(response), "%lu:201", seqValue);        // The response template echoes the seq
+      deliverEvent(topic, response);
+    });
+  }
+
+  uint64_t coverageSince(uint64_t at) {
+    static uint64_t cachedHour = UINT64_MAX, cachedSince;
+    uint64_t hour = at / HOUR;
+    if (hour != cachedHour) {
+      cachedHour = hour;
+      if (outageHour(hour)) cachedSince = UINT64_MAX;
+      else {
+        uint64_t first = hour;
+        while (first > 0 && !outageHour(first - 1)) first--;
+        cachedSince = first * HOUR;
+      }
+    }
+    return cachedSince;
+  }
+
+  void reset(int reason, uint64_t offMicros) {
+    if (shared->pumpOnAt) {                                             // The relay drops out with the processor
+      shared->stats.pumpResets++;
+      shared->pumpOnAt = 0;
+    }
+    switch (reason) {
+      case RESET_REASON_PIN_RESET: shared->stats.resetsPin++; break;
+      case RESET_REASON_USER: shared->stats.resetsUser++; break;
+      case RESET_REASON_POWER_MANAGEMENT: shared->stats.resetsSleep++; break;
+      default: shared->stats.resetsPowerCycle++; break;
+    }
+    shared->resetReason = reason;
+    advance(offMicros);
+    endBoot();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "d:f:o:s:t:r:pv")) != -1) {
+    switch (opt) {
+      case 'd': config.days = atoi(optarg); break;
+      case 'f': config.hookFailPercent = atoi(optarg); break;
+      case 'o': config.outagePercent = atoi(optarg); break;
+      case 's': config.seed = strtoull(optarg, NULL, 0); break;
+      case 't': config.stepMicros = strtoull(optarg, NULL, 0) * 1000; break;
+      case 'r': config.reportFormat = optarg; break;
+      case 'p': config.tracePublishes = true; break;
+      case 'v': sim::verbose = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-d days] [-f hookFailPercent] [-o outagePercent] [-s seed] [-t stepMs] [-r format] [-p] [-v]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (config.stepMicros == 0) config.stepMicros = 1000;
+
+  sim::startEpoch = 1609459200;                                         // 2021-01-01 00:00:00 UTC
+
+  shared = (Shared *)mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  memset(shared, 0, sizeof(Shared));                                   // FRAM starts erased, as after Reset-FRAM
+  shared->resetReason = RESET_REASON_POWER_DOWN;
+
+  auto wallStart = std::chrono::steady_clock::now();
+  while (!shared->done) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) runBoot();
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "boot %u did not end cleanly\n", shared->stats.boots);
+      return 1;
+    }
+  }
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+  printSummary(wall.count());
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include "BurstSampler.h"
+
+BurstSampler::BurstSampler(int pin, size_t samples, unsigned long intervalMicros) :
+  pin(pin), count((samples && samples <= MAX_SAMPLES) ? samples : DEFAULT_SAMPLES), intervalMicros(intervalMicros) {
+}
+
+void BurstSampler::sample() {
+  unsigned long next = micros();
+  for (size_t i = 0; i < count; i++) {
+    long wait = (long)(next - micros());
+    if (wait > 0) delayMicroseconds(wait);                              // Paced from the start of the burst so the ADC time does not add up
+    samples[i] = analogRead(pin);
+    next += intervalMicros;
+  }
+
+  uint32_t sum = 0;                                                     // 256 x 4095 fits in 20 bits
+  uint64_t sumSquares = 0;                                              // 256 x 4095^2 needs 32 bits and a little more
+  uint16_t highest = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t value = samples[i];
+    sum += value;
+    sumSquares += value * value;
+    if (value > highest) highest = value;
+  }
+
+  meanCounts = (sum + count / 2) / count;
+  rmsCounts = isqrt((sumSquares + count / 2) / count);
+  uint64_t spread = (uint64_t)count * sumSquares - (uint64_t)sum * sum; // count^2 x variance - never negative
+  acRmsCounts = (isqrt(spread) + count / 2) / count;
+  peakCounts = highest;
+}
+
+uint32_t BurstSampler::isqrt(uint64_t value) {                          // Bit at a time - no division or floating point
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > value) bit >>= 2;
+  while (bit) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else root >>= 1;
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
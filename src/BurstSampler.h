@@ -0,0 +1,41 @@
+#ifndef __BURSTSAMPLER_H
+#define __BURSTSAMPLER_H
+
+#include "Particle.h"
+
+// Takes a fixed-rate burst of ADC readings that spans whole mains cycles and reduces it to
+// mean, true RMS and peak with integer math only. One analogRead() lands on a random point of
+// the waveform - the burst statistics do not depend on where in the cycle it started.
+class BurstSampler {
+public:
+  static const size_t MAX_SAMPLES = 256;
+  static const size_t DEFAULT_SAMPLES = 200;
+  static const unsigned long DEFAULT_INTERVAL_MICROS = 167;            // 200 x 167 us is two 60 Hz cycles (33.4 ms)
+
+  BurstSampler(int pin, size_t samples = DEFAULT_SAMPLES, unsigned long intervalMicros = DEFAULT_INTERVAL_MICROS);
+
+  void sample();                                                        // Blocks for samples x intervalMicros
+
+  // Results of the last burst, in ADC counts (0 - 4095)
+  int mean() const { return meanCounts; }
+  int rms() const { return rmsCounts; }                                 // True RMS including the DC part
+  int acRms() const { return acRmsCounts; }                             // RMS about the mean - the ripple
+  int peak() const { return peakCounts; }
+
+  const uint16_t *buffer() const { return samples; }
+  size_t size() const { return count; }
+
+  static uint32_t isqrt(uint64_t value);
+
+protected:
+  int pin;
+  size_t count;
+  unsigned long intervalMicros;
+  uint16_t samples[MAX_SAMPLES];
+  int meanCounts = 0;
+  int rmsCounts = 0;
+  int acRmsCounts = 0;
+  int peakCounts = 0;
+};
+
+#endif /* __BURSTSAMPLER_H */
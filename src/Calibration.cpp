@@ -0,0 +1,66 @@
+#include "Calibration.h"
+
+#include <stdlib.h>
+
+int CalibrationTable::lookup(int raw) const {
+  size_t i = 0;
+  while (i + 2 < count && raw > points[i + 1].raw) i++;                 // Segment i runs from point i to point i + 1
+  long run = points[i + 1].raw - points[i].raw;
+  long rise = (long)(raw - points[i].raw) * (points[i + 1].value - points[i].value);
+  return points[i].value + (rise + (rise >= 0 ? run / 2 : -run / 2)) / run;  // Rounded, not truncated toward zero
+}
+
+bool CalibrationTable::valid() const {
+  if (count < 2 || count > MAX_POINTS) return false;
+  for (size_t i = 1; i < count; i++) {
+    if (points[i].raw <= points[i - 1].raw) return false;               // Also rules out a zero length segment
+  }
+  return true;
+}
+
+bool CalibrationTable::parse(const char *text) {
+  CalibrationTable table = {0, 0, 0, {}};
+  const char *p = text;
+  while (*p) {
+    if (table.count == MAX_POINTS) return false;
+    char *end;
+    long raw = strtol(p, &end, 10);
+    if (end == p || *end != '=' || raw < 0 || raw > 4095) return false;
+    p = end + 1;
+
+    bool negative = (*p == '-');
+    if (negative) p++;
+    long whole = strtol(p, &end, 10);
+    if (end == p || *p == '-' || *p == '+') return false;
+    long tenths = whole * 10;
+    p = end;
+    if (*p == '.') {
+      p++;
+      if (*p >= '0' && *p <= '9') tenths += *p - '0';                   // One decimal is all the table keeps
+      while (*p >= '0' && *p <= '9') p++;
+    }
+    if (negative) tenths = -tenths;
+    if (tenths < INT16_MIN || tenths > INT16_MAX) return false;
+
+    table.points[table.count].raw = (int16_t)raw;
+    table.points[table.count].value = (int16_t)tenths;
+    table.count++;
+
+    while (*p == ' ') p++;
+    if (*p == ',') p++;
+    else if (*p) return false;
+    while (*p == ' ') p++;
+  }
+  if (!table.valid()) return false;
+  *this = table;
+  return true;
+}
+
+uint16_t CalibrationTable::checksum() const {
+  uint16_t sum = (uint16_t)~count;                                      // An erased table (all zero) does not check
+  for (size_t i = 0; i < count && i < MAX_POINTS; i++) {
+    sum = (uint16_t)((sum << 5) | (sum >> 11));
+    sum ^= (uint16_t)points[i].raw ^ (uint16_t)(points[i].value * 31);
+  }
+  return sum;
+}
@@ -0,0 +1,48 @@
+#ifndef __CALIBRATION_H
+#define __CALIBRATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Piecewise-linear sensor calibration in fixed point - ADC counts in, tenths of a unit out
+// A conversion is a walk along at most eight points and one integer interpolation, so there is
+// no soft-float on the Cortex-M3. Tables are plain data so a site's own points can live in FRAM.
+struct CalibrationPoint {
+  int16_t raw;                                                          // ADC counts, 0 - 4095
+  int16_t value;                                                        // Tenths of a degree or an amp
+};
+
+struct CalibrationTable {
+  static const size_t MAX_POINTS = 8;
+
+  uint8_t count;
+  uint8_t reserved;
+  uint16_t check;                                                       // Only used for the copy in FRAM - see seal()
+  CalibrationPoint points[MAX_POINTS];
+
+  int lookup(int raw) const;                                            // Tenths - beyond the end points the end segment is extended
+
+  bool valid() const;                                                   // 2 to MAX_POINTS points in increasing raw order
+  bool intact() const { return valid() && check == checksum(); }        // valid() and not torn or erased - for tables read from FRAM
+  void seal() { check = checksum(); }                                   // Call before writing to FRAM
+
+  // Replaces the points with "raw=value,raw=value,..." - values may have one decimal ("412=-3.5")
+  // Leaves the table alone and returns false if the text does not make a valid table
+  bool parse(const char *text);
+
+  uint16_t checksum() const;
+};
+
+namespace Calibration {
+  // TMP36 - 10 mV per degree C with a 500 mV offset, on a 3.3V 12 bit ADC - in tenths of a degree F
+  constexpr int16_t tmp36Tenths(int raw) { return (int16_t)(((long)raw * 29700 + 10240) / 20480 - 580); }
+  constexpr CalibrationPoint tmp36Point(int raw) { return CalibrationPoint{(int16_t)raw, tmp36Tenths(raw)}; }
+
+  // Built by the compiler from the data sheet formulas - used until a site loads its own points
+  constexpr CalibrationTable TMP36 = {5, 0, 0, {tmp36Point(0), tmp36Point(1024), tmp36Point(2048), tmp36Point(3072), tmp36Point(4095)}};
+  constexpr CalibrationTable PUMP_CURRENT = {2, 0, 0, {{0, 0}, {4095, 320}}};   // Transducer is linear from 0 to 32 Amps
+
+  inline int roundTenths(int tenths) { return tenths >= 0 ? (tenths + 5) / 10 : -((5 - tenths) / 10); }
+}
+
+#endif /* __CALIBRATION_H */
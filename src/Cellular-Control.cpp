@@ -38,64 +38,144 @@
 // v1.62 - Bugfixes: Cleaned up alert reporting in the particle console
 // v1.63 - Updated to deviceOS@2.3.0
 // v1.64 - Serial Log Handler, Log info messages
+// v1.65 - Reset-FRAM erases in the background so the main loop is never stalled
+// v1.66 - RAM cache of the FRAM configuration region - no I2C traffic for reads or unchanged writes
+// v1.67 - Multi-field FRAM updates are written together in one bus session
+// v1.68 - Typed FRAM memory map checked at compile time - pumpingStart is stored as 32 bits so it no longer overlaps lastHookResponse
+// v1.69 - Reports are queued in FRAM until the webhook confirms them - undelivered reports survive resets and are sent after reconnect
+// v1.70 - Publishes go through a prioritized queue drained from loop() - the main loop no longer waits on the publish rate limit
+// v1.71 - Report, DST and midnight times are kept as deadlines - added Set-Interval for 15, 30 or 60 minute reports
+// v1.72 - Signal strength is read every 5 minutes and before reports instead of every sample - reports include the window mean
+// v1.73 - Pump current is the RMS of a burst of samples over two mains cycles instead of a single reading
+// v1.74 - Temperature and pump current use fixed-point calibration tables - Set-Calibration loads site points into FRAM
+// v1.75 - Sampling is fast while pumping or after a change and backs off to 30 seconds when quiet - input changes sample at once
+// v1.76 - Control power and low level are captured by pin interrupts and debounced - a dip between measurements still raises the alert
+// v1.77 - Pump commands from the cloud and the failsafe timer go through a sequenced mailbox - only loop() changes pumpCalled
+// v1.78 - The relay is switched at the top of every loop() pass instead of from PUMPING_STATE - each switch publishes its command latency
+// v1.79 - The 95 minute failsafe counts from the pumping start in FRAM - a reset mid run resumes pumping with the budget that is left
+// v1.80 - Two phase boot - FRAM, lockout, failsafe and pump relay are restored before the cloud connection, which no longer blocks setup()
+// v1.81 - Connection manager - connects and disconnects without blocking loop(), backs off after a failure instead of resetting, times each phase
+// v1.82 - Reports carry a sequence number the webhook echoes back - up to four are in flight at once and acks are matched by number
+// v1.83 - Report-Format function - Monitoring_Event can go out as a packed binary record in Base64, about a sixth of the JSON
+// v1.84 - With binary reports a backlog goes out in batches - up to 17 reports to a publish and one webhook response each
+// v1.85 - Report-Format delta - hourly reports carry only the fields changed since the last acknowledged one, with a full report daily
+// v1.86 - Reports carry the min, max, mean and standard deviation of pump current, temperature and battery over the window
 
-// Namespace for the FRAM storage
+// For monitoring / debugging, you can uncomment the next line
 void setup();
 void loop();
-void pumpTimerCallback();
+void applyPumpCommands();
+void actuatePump();
 void resolveAlert();
-void sendEvent();
+void queueReport();
+bool sendEvent();
+void publishDropped(const char *name, uint32_t tag);
 void UbidotsHandler(const char *event, const char *data);
+void releaseDelivered();
 void getSignalStrength();
 int getTemperature();
 void watchdogISR();
 void petWatchdog();
-bool connectToParticle();
-bool disconnectFromParticle();
-bool notConnected();
+void connectionChanged();
+void saveConnectionStats();
 void takeMeasurements();
+uint8_t readInputs();
 int pumpControl(String command);
 int setPumpLockout(String command);
 int resetFRAM(String command);
+void eraseFRAMProcess();
 int resetCounts(String command);
 int hardResetNow(String command);
 int sendNow(String command);
 int setVerboseMode(String command);
-bool meterParticlePublish(void);
-bool meterSampleRate(void);
+int setReportFormat(String command);
 void fullModemReset();
 void pumpControlHandler(const char *event, const char *data);
 void dailyCleanup();
 void publishStateTransition(void);
 int setTimeZone(String command);
+int setReportInterval(String command);
+int setCalibration(String command);
+void loadTimeZone();
+bool migrateFRAM(uint8_t version);
+void loadCalibration();
 bool isDSTusa();
-#line 37 "/Users/chipmc/Documents/Maker/Particle/Projects/Cellular-Control/src/Cellular-Control.ino"
-namespace FRAM {                                    // Moved to namespace instead of #define to limit scope
-  enum Addresses {
-    versionAddr           = 0x00,                   // 8- bits - Where we store the memory map version number
-    controlRegisterAddr   = 0x04,                   // 8- bits - The control register for the device
-    timeZoneAddr          = 0x08,                   // 8- bits - The time zone for the device (Note, assumes US based Device)
-    resetCountAddr        = 0x0C,                   // 32-bits - How many resets today
-    pumpingLockoutAddr    = 0x10,                   // Adding a function to lock out pumping
-    dailyPumpingMinsAddr  = 0x20,                   // 32-bits - How many minutes have we pumped today
-    pumpingStartAddr      = 0x24,                   // 32-bits - Unix Time
-    lastHookResponseAddr  = 0x28                    // 32-bits - Unix Time 
-  };
-};
-
-// For monitoring / debugging, you can uncomment the next line
+#line 59 "/Users/chipmc/Documents/Maker/Particle/Projects/Cellular-Control/src/Cellular-Control.ino"
 SerialLogHandler logHandler(LOG_LEVEL_INFO);
 
 // Finally, here are the variables I want to change often and pull them all together here
-#define FRAMMEMORYMAPVERSION 1
-#define SOFTWARERELEASENUMBER "1.64"
+#define FRAMMEMORYMAPVERSION 4
+#define SOFTWARERELEASENUMBER "1.86"
 // #define PUMPCHANNEL "FallsLakeBeaverDamn-FallsLake3-PumpControl"
 #define DSTRULES isDSTusa
 
 // Included Libraries
 #include "MB85RC256V-FRAM-RK.h"
+#include "MB85RCCache.h"
+#include "MB85RCLayout.h"
+#include "MB85RCRing.h"
+#include "MonitoringReport.h"
+#include "ReportCodec.h"
+#include "PublishQueue.h"
+#include "ReportSchedule.h"
+#include "SignalCache.h"
+#include "BurstSampler.h"
+#include "Calibration.h"
+#include "SamplePolicy.h"
+#include "RunningStats.h"
+#include "EdgeCapture.h"
+#include "CommandMailbox.h"
+#include "PumpFailsafe.h"
+#include "ConnectionManager.h"
+#include "DeliveryWindow.h"
 #include "electrondoc.h"                                              // Documents pinout term
 
+// FRAM memory map - each field's size comes from its type and MB85RCLayout checks for overlaps at compile time
+namespace FRAM {                                                        // Moved to namespace instead of #define to limit scope
+  typedef MB85RCField<0x00, uint8_t> Version;                           // Where we store the memory map version number
+  typedef MB85RCFieldAfter<Version, uint8_t, 4> ControlRegister;        // 0x04 - The control register for the device
+  typedef MB85RCFieldAfter<ControlRegister, int8_t, 4> TimeZone;        // 0x08 - The time zone for the device (Note, assumes US based Device)
+  typedef MB85RCFieldAfter<TimeZone, int, 4> ResetCount;                // 0x0C - How many resets today
+  typedef MB85RCFieldAfter<ResetCount, bool, 4> PumpingLockout;         // 0x10 - Adding a function to lock out pumping
+  typedef MB85RCField<0x20, int> DailyPumpingMins;                      // How many minutes have we pumped today
+  typedef MB85RCFieldAfter<DailyPumpingMins, uint32_t, 4> PumpingStart; // 0x24 - Unix Time - 32 bits as time_t is 64 bits on deviceOS 2.x and would overlap the next field
+  typedef MB85RCFieldAfter<PumpingStart, uint32_t, 4> LastHookResponse; // 0x28 - Unix Time
+  typedef MB85RCFieldAfter<LastHookResponse, uint8_t> ReportInterval;   // 0x2C - Minutes between reports - 15, 30 or 60
+
+  typedef MB85RCField<0x30, CalibrationTable> TempCalibration;          // Site calibration - read once at startup
+  typedef MB85RCFieldAfter<TempCalibration, CalibrationTable, 4> CurrentCalibration;
+  typedef MB85RCFieldAfter<CurrentCalibration, ConnectionManager::Stats, 4> ConnectStats; // Connect time histograms - written after each attempt
+  typedef MB85RCFieldAfter<ConnectStats, uint32_t, 4> ReportSequence;   // Sequence number for the next report - written as each is queued
+  typedef MB85RCFieldAfter<ReportSequence, uint32_t> CleanupDeadline;   // Unix Time the next daily cleanup is due - so a reset does not skip one
+
+  typedef MB85RCRing<MonitoringReport, 168> ReportRing;                 // A week of hourly reports
+  typedef MB85RCField<0x100, ReportRing::Storage> ReportQueue;          // Unsent reports - last, so a bigger report never moves the fields above. Room for 47 bytes a report
+
+  typedef MB85RCLayout<8192, Version, ControlRegister, TimeZone, ResetCount, PumpingLockout,
+                       DailyPumpingMins, PumpingStart, LastHookResponse, ReportInterval, TempCalibration,
+                       CurrentCalibration, ConnectStats, ReportSequence, CleanupDeadline, ReportQueue> Layout;  // Will not compile if fields overlap or do not fit the MB85RC64
+  typedef MB85RCGroup<TempCalibration, CurrentCalibration, ConnectStats, ReportSequence, CleanupDeadline> Settings;  // Carried over from the older layouts
+
+  typedef MB85RCGroup<ControlRegister, PumpingStart> PumpingSession;    // Written together when pumping starts
+  typedef MB85RCGroup<ControlRegister, DailyPumpingMins> PumpingTotals; // Written together when pumping stops and at the daily cleanup
+  typedef MB85RCGroup<ResetCount, DailyPumpingMins> Counts;             // Zeroed together by Reset-Counts
+};
+
+namespace FRAMLegacy {                                                  // Versions 1 to 3 kept the settings after the report ring, so they moved whenever a report grew
+  template <size_t RECORD_SIZE> struct Map {
+    typedef MB85RCField<0x30, uint8_t[2 * sizeof(FRAM::ReportRing::Header) + 168 * RECORD_SIZE]> ReportQueue;
+    typedef MB85RCFieldAfter<ReportQueue, CalibrationTable, 16> TempCalibration;
+    typedef MB85RCFieldAfter<TempCalibration, CalibrationTable, 4> CurrentCalibration;
+    typedef MB85RCFieldAfter<CurrentCalibration, ConnectionManager::Stats, 4> ConnectStats;
+    typedef MB85RCFieldAfter<ConnectStats, uint32_t, 4> ReportSequence;   // From version 2
+    typedef MB85RCFieldAfter<ReportSequence, uint32_t> CleanupDeadline; // Version 3 only
+    typedef MB85RCGroup<TempCalibration, CurrentCalibration, ConnectStats, ReportSequence, CleanupDeadline> Settings;
+  };
+  typedef Map<16> V1;                                                   // MonitoringReport sizes - the calibration tables and stats carry checksums, so
+  typedef Map<20> V2;                                                   // a version 1 device from before they existed falls back to the defaults
+  typedef Map<44> V3;
+};
+
 // Prototypes and System Mode calls
 SYSTEM_MODE(SEMI_AUTOMATIC);                                          // These devices are always connected
 SYSTEM_THREAD(ENABLED);                                               // Means my code will not be held up by Particle processes.
@@ -103,10 +183,27 @@ STARTUP(System.enableFeature(FEATURE_RESET_INFO));
 FuelGauge batteryMonitor;                                             // Prototype for the fuel gauge (included in Particle core library)
 PMIC power;                                                           // Enables us to monitor the power supply to the board
 MB85RC64 fram(Wire, 0);
+MB85RCCacheStatic<FRAM::ReportInterval::end> framCache(fram, 0, MB85RCCache::WRITE_THROUGH);   // Reads are from RAM, only changed values are written
+FRAM::ReportRing reportQueue(fram, FRAM::ReportQueue::addr);          // Store and forward - reports stay here until the webhook responds
+PublishQueue publishQueue;                                            // All publishes go through here - sent from loop() at the cloud rate limit
+ReportSchedule reportSchedule;                                        // When the next report, DST check and daily cleanup are due
+SignalCache signalCache;                                              // Modem signal readings - refreshed on their own cadence
+CalibrationTable tempCalibration = Calibration::TMP36;                // Replaced by the FRAM copy if a site has loaded one
+CalibrationTable currentCalibration = Calibration::PUMP_CURRENT;
+SamplePolicy samplePolicy;                                            // When the next measurement is due
+RunningStats ampsStats;                                               // Each measurement over the reporting window, in tenths - started over by each report
+RunningStats temperatureStats;
+RunningStats batteryStats;
+unsigned long statsSampledAt = 0;                                     // millis() of the last measurement added - weights the next
+EdgeCapture edgeCapture;                                              // Interrupt driven, debounced control power and low level inputs
+CommandMailbox pumpCommands;                                          // Pump on / off from the cloud handlers and the failsafe - applied in order by loop()
+PumpFailsafe pumpFailsafe;                                            // Longest the pump may run on one call - survives resets
+ConnectionManager connection;                                         // Modem and cloud session - loop() polls it, nothing waits on it
+DeliveryWindow deliveries;                                            // Reports published and waiting on the webhook
 
 // State Machine Variables
-enum State { INITIALIZATION_STATE, ERROR_STATE, IDLE_STATE, PUMPING_STATE, LOW_BATTERY_STATE, REPORTING_STATE, RESP_WAIT_STATE };
-char stateNames[8][14] = {"Initialize", "Error", "Idle", "Pumping", "Low Battery", "Reporting", "Response Wait" };
+enum State { INITIALIZATION_STATE, ERROR_STATE, IDLE_STATE, LOW_BATTERY_STATE, REPORTING_STATE, RESP_WAIT_STATE };
+char stateNames[7][14] = {"Initialize", "Error", "Idle", "Low Battery", "Reporting", "Response Wait" };
 State state = INITIALIZATION_STATE;
 State oldState = INITIALIZATION_STATE;
 
@@ -127,11 +224,11 @@ const int blueLED =           D7;               // This LED is on the Electron i
 
 // On the headers, GND is Blue-White and 3.3V is Orange
 
+BurstSampler pumpCurrentSampler(pumpCurrentPin);                        // Two mains cycles of the current sensor per sample
+
 // Timing Variables
 unsigned long webhookWait = 45000;                                    // How long we will wair for a webhook response
 unsigned long resetWait = 30000;                                      // Honw long we will wait before resetting on an error
-unsigned long sampleFrequency = 2000;                                 // How often will we take a sample
-unsigned long webhookTimeStamp = 0;
 unsigned long resetTimeStamp = 0;
 volatile bool watchdogFlag = false;
 
@@ -142,6 +239,12 @@ const char* releaseNumber = SOFTWARERELEASENUMBER;                    // Display
 byte controlRegister;                                                 // Stores the control register values
 int lowBattLimit = 30;                                                // Trigger for Low Batt State
 bool verboseMode;                                                     // Enables more active communications for configutation and setup
+bool binaryReports;                                                   // Monitoring_Event data is a ReportCodec record - the webhook has to decode it
+bool deltaReports;                                                    // Binary reports as deltas against deltaBase - a full one every keyframeInterval
+MonitoringReport deltaBase;                                           // The last report the webhook acknowledged - it keeps a copy to apply deltas to
+bool haveDeltaBase = false;                                           // Not after a reset - the first report is then a full one
+uint32_t keyframeSeq;                                                 // The last report sent in full
+const uint32_t keyframeInterval = 24;                                 // Reports - a day of hourly ones. Bounds what a webhook that lost its copy misses
 char SignalString[64];                                                // Used to communicate Wireless RSSI and Description
 const char* radioTech[10] = {"Unknown","None","WiFi","GSM","UMTS","CDMA","LTE","IEEE802154","LTE_CAT_M1","LTE_CAT_NB1"};
 char currentOffsetStr[10];                                            // What is our offset from UTC
@@ -150,8 +253,7 @@ char currentOffsetStr[10];                                            // What is
 // FRAM and Unix time variables
 time_t t;
 int alertValue = 0;                                                   // Current Active Alerts
-bool dataInFlight = false;                                            // Tracks if we have sent data but not yet cleared it from counts until we get confirmation
-byte currentHourlyPeriod;                                             // This is where we will know if the period changed
+uint32_t nextReportSeq = 0;                                           // Kept in FRAM so numbers are not reused after a reset
 
 // Battery monitor
 int stateOfCharge = 0;                                                // stores battery charge level value
@@ -161,18 +263,28 @@ int pumpAmps = 0;
 int pumpCurrentRaw = 0;
 time_t pumpingStart = 0;
 int dailyPumpingMins = 0;
-bool pumpCalled = false;
+bool pumpCalled = false;                                              // Only written by applyPumpCommands() in loop()
+CommandMailbox::Command pumpCommand = {0, 0, CommandMailbox::LOCAL, 0};  // The command that set pumpCalled - for the latency
+int pumpLatencyMs = 0;                                                // Command to relay for the last switch
+bool clockSet = false;                                                // The RTC had the time when we started, or the cloud has set it since
+bool timeSyncPending = false;                                         // The daily Particle.syncTime() has not finished
+const uint16_t connectFailuresBeforeReset = 6;                        // About 20 minutes of attempts and backoff - then the error state escalation
+char connectionString[96];                                            // Connect time histograms - see ConnectionManager::format()
+int controlPowerInput = -1;                                           // edgeCapture channels
+int lowLevelInput = -1;
 bool pumpLockOut = false;
 
 
-Timer pumpBackupTimer(5700000, pumpTimerCallback, true);              // This sets a limit on how long we can pump - set to 95 minutes at Vinny's Request - email 3/3/21
 
 void setup()                                                          // Note: Disconnected Setup()
 {
+  // Phase one - back in control of the pump within milliseconds of a reset - nothing here waits on the network
   pinMode(pumpControlPin,OUTPUT);                                     // Turns on the pump
   pinMode(pumpCurrentPin,INPUT);                                      // Senses the pump current
   pinMode(controlPowerPin,INPUT);                                     // Voltage Sensor Interrupt pin
   pinMode(lowLevelPin,INPUT);                                         // Voltage Sensor Interrupt pin
+  controlPowerInput = edgeCapture.add(controlPowerPin);                 // Both inputs are debounced for 50 mSec
+  lowLevelInput = edgeCapture.add(lowLevelPin);
   pinMode(userSwitch,INPUT);                                          // Momentary contact button on board for direct user input
   pinMode(blueLED, OUTPUT);                                           // declare the Blue LED Pin as an output
   pinMode(tmp36Shutdwn,OUTPUT);                                       // Supports shutting down the TMP-36 to save juice
@@ -185,12 +297,54 @@ void setup()                                                          // Note: D
   petWatchdog();                                                      // Proactively pet the watchdog
   attachInterrupt(wakeUpPin, watchdogISR, RISING);                    // The watchdog timer will signal us and we have to response
 
-  Particle.connect();
+  fram.begin();                                                         // Initializes Wire but does not return a boolean on successful initialization
+  framCache.begin();                                                    // Restores the whole configuration region in one sequential read - the gets below are from RAM
+  bool staleQueue = false;
+  if (framCache.get<FRAM::Version>() != FRAMMEMORYMAPVERSION) {         // Older firmware kept the settings somewhere else
+    staleQueue = !migrateFRAM(framCache.get<FRAM::Version>());
+  }
+  reportQueue.begin();                                                  // Picks up any reports that were not delivered before the reset
+  if (staleQueue) reportQueue.clear();                                  // Reports queued with a different record layout
+  nextReportSeq = fram.get<FRAM::ReportSequence>();
+  loadCalibration();
+
+  resetCount = framCache.get<FRAM::ResetCount>();                       // Retrive system recount data from FRAM
+  if (System.resetReason() == RESET_REASON_PIN_RESET) {                 // Check to see if we are starting from a pin reset
+    resetCount++;
+    framCache.put<FRAM::ResetCount>(resetCount);                        // If so, store incremented number - watchdog must have done This
+  }
+
+  // Get Time Squared Away - the RTC keeps time through a reset, so this does not wait for the cloud
+  loadTimeZone();
+  clockSet = Time.isValid();                                            // False after a power loss - then the schedule waits for the cloud time sync
 
+  stateOfCharge = int(batteryMonitor.getSoC());                         // Percentage of full charge
+  pumpLockOut = framCache.get<FRAM::PumpingLockout>();                  // Retreive the value from memory so it persists - before the pump is touched
+  controlRegister = framCache.get<FRAM::ControlRegister>();
+  verboseMode = (0b00001000 & controlRegister);                         // verboseMode
+  binaryReports = (0b00010000 & controlRegister);                       // Report format
+  deltaReports = (0b00100000 & controlRegister);
+  dailyPumpingMins = framCache.get<FRAM::DailyPumpingMins>();           // Reload so we don't loose track
+  if (controlRegister & 0b00000010) {                                   // This means we reset while pumpting
+    pumpingStart = framCache.get<FRAM::PumpingStart>();                 // Reload the pumping start time
+    uint32_t budgetLeft = clockSet ? PumpFailsafe::budgetLeft(pumpingStart, Time.now()) : 0;
+    if (budgetLeft && stateOfCharge > lowBattLimit) {
+      pumpFailsafe.arm(budgetLeft);                                     // Same deadline as before the reset
+      pumpCommands.post(CommandMailbox::LOCAL, 1);                      // Pick the run back up - the off command or the failsafe will end it
+      Log.info("Resuming pumping - %lu seconds of budget left", (unsigned long)budgetLeft);
+    }
+  }
+  applyPumpCommands();                                                  // The relay is back on here, not after the connection
+  actuatePump();
+
+  reportSchedule.begin(framCache.get<FRAM::ReportInterval>(), fram.get<FRAM::CleanupDeadline>());  // Reports once right away - or once the clock is set
+
+  // Phase two - the cloud. Registering is local, the connection comes up in the background and loop() keeps an eye on it
   char responseTopic[125];
   String deviceID = System.deviceID();                                // Multiple Electrons share the same hook - keeps things straight
   deviceID.toCharArray(responseTopic,125);
   Particle.subscribe(responseTopic, UbidotsHandler, MY_DEVICES);      // Subscribe to the integration response event
+  publishQueue.onDrop(publishDropped);
 
   /*
   if (Particle.subscribe(PUMPCHANNEL, pumpControlHandler, MY_DEVICES)) {
@@ -209,7 +363,9 @@ void setup()                                                          // Note: D
   Particle.variable("pumpMinutes",dailyPumpingMins);
   Particle.variable("TimeOffset",currentOffsetStr);
   Particle.variable("PumpCalled", pumpCalled);
+  Particle.variable("PumpLatency", pumpLatencyMs);
   Particle.variable("PumpLockOut", pumpLockOut);
+  Particle.variable("Connection", connectionString);
 
   Particle.function("Reset-FRAM", resetFRAM);
   Particle.function("PumpCalled",pumpControl);
@@ -219,80 +375,62 @@ void setup()                                                          // Note: D
   Particle.function("Verbose-Mode",setVerboseMode);
   Particle.function("Set-Timezone",setTimeZone);
   Particle.function("PumpLockout",setPumpLockout);
+  Particle.function("Set-Interval",setReportInterval);
+  Particle.function("Set-Calibration",setCalibration);
+  Particle.function("Report-Format",setReportFormat);
 
-  fram.begin();                                                         // Initializes Wire but does not return a boolean on successful initialization
-
-  fram.get(FRAM::resetCountAddr, resetCount);                           // Retrive system recount data from FRAM
-  if (System.resetReason() == RESET_REASON_PIN_RESET) {                 // Check to see if we are starting from a pin reset
-    resetCount++;
-    fram.put(FRAM::resetCountAddr,resetCount);                          // If so, store incremented number - watchdog must have done This
-  }
-
-  fram.get(FRAM::controlRegisterAddr, controlRegister);
-  verboseMode = (0b00001000 & controlRegister);                         // verboseMode
-  fram.get(FRAM::dailyPumpingMinsAddr,dailyPumpingMins);                // Reload so we don't loose track
-  if (controlRegister & 0b00000010) {                                   // This means we reset while pumpting
-    fram.get(FRAM::pumpingStartAddr,pumpingStart);                      // Reload the pumping start time
-  }
-  // Get Time Squared Away
-  int8_t tempTimeZoneValue;
-  fram.get(FRAM::timeZoneAddr,tempTimeZoneValue);
-  if (tempTimeZoneValue > 12 || tempTimeZoneValue < -12) {
-    tempTimeZoneValue = -5;
-    fram.put(FRAM::timeZoneAddr,tempTimeZoneValue);                     // Load the default value into FRAM for next time
-  }
-  Time.zone((float)tempTimeZoneValue);                                  // Implement the local time Zone value
-  snprintf(currentOffsetStr,sizeof(currentOffsetStr),"%2.1f UTC",(Time.local() - Time.now()) / 3600.0);
-
-  stateOfCharge = int(batteryMonitor.getSoC());                         // Percentage of full charge
-  if (stateOfCharge > lowBattLimit) {
-    if (!connectToParticle()) state = ERROR_STATE;                        // If not low battery, we can connect
-    Log.info("Failed connection attempt");
-  }
-
-  pumpBackupTimer.stop();
-
-  fram.get(FRAM::pumpingLockoutAddr,pumpLockOut);                       // Retreive the value from memory so it persists
+  connection.restoreStats(fram.get<FRAM::ConnectStats>());              // So the escalation resets do not lose the failed attempts
+  connection.format(connectionString, sizeof(connectionString));
+  if (stateOfCharge > lowBattLimit) connection.connect();               // Returns right away - loop() brings up the modem and the cloud. If low battery we will be going to sleep instead
 
-  if (state != ERROR_STATE) state = IDLE_STATE;                         // IDLE unless error from above code
+  state = IDLE_STATE;
 }
 
 void loop()
 {
+  if (connection.loop()) connectionChanged();                           // An attempt just connected or failed - never waits on the modem
+  publishQueue.loop();                                                  // Sends the most important waiting publish if the rate limit allows
+  if (edgeCapture.loop()) samplePolicy.trigger();                       // An input changed, even if it has already changed back - measure now
+  applyPumpCommands();                                                  // Before the state machine so a command is acted on in this pass
+  if (pumpFailsafe.expired()) {                                         // Ran too long - turn off as if the off command had come
+    if (pumpCommands.post(CommandMailbox::FAILSAFE, 0)) pumpFailsafe.disarm();  // Still armed if the mailbox was full - draining it below makes room for next pass
+    applyPumpCommands();
+  }
+  actuatePump();                                                        // The relay follows within one pass, whatever the state
+  if (fram.isFillBusy()) {                                              // Reset-FRAM - the states wait, so nothing writes the FRAM mid erase
+    if (watchdogFlag) petWatchdog();
+    eraseFRAMProcess();                                                 // One slice per pass
+    return;
+  }
+
   switch(state) {
   case IDLE_STATE:
     if (verboseMode && state != oldState) publishStateTransition();
     if (watchdogFlag) petWatchdog();
-    if (Time.hour() != currentHourlyPeriod) state = REPORTING_STATE;     // We want to report on the hour
-    if (stateOfCharge <= lowBattLimit) state = LOW_BATTERY_STATE;        // The battery is low - sleep
-    if (pumpCalled || digitalRead(pumpControlPin)) state = PUMPING_STATE;// If we are pumping, we need to report
-    if (meterSampleRate()) takeMeasurements();                           // Take measurements every couple seconds
-    break;
-
-  case PUMPING_STATE: {
-    if (verboseMode && state != oldState) publishStateTransition();
-
-    if (pumpCalled && !pumpLockOut && !digitalRead(pumpControlPin)) {   // First time to this state we will turn on the pump and report
-      digitalWrite(pumpControlPin,HIGH);
-      digitalWrite(blueLED,HIGH);
-      Log.info("Pump Turned On");
-      pumpBackupTimer.start();
+    framCache.loop();                                                   // Only writes if the cache policy is DEFERRED
+    if (timeSyncPending && Particle.syncTimeDone()) {                   // Also true if the connection dropped - then the clock is as it was
+      timeSyncPending = false;
+      reportSchedule.recompute();                                       // In case the time sync moved the clock
+      fram.put<FRAM::CleanupDeadline>((uint32_t)reportSchedule.nextCleanup());
     }
-    else if (!pumpCalled && digitalRead(pumpControlPin)) {
-      digitalWrite(pumpControlPin,LOW);
-      digitalWrite(blueLED,LOW);
-      Log.info("Pump turned Off");
-      pumpBackupTimer.stop();
+    if (!reportQueue.empty() && Particle.connected()) state = RESP_WAIT_STATE; // Undelivered reports from before a reset - drain them
+    if (Time.isValid() && Time.now() >= reportSchedule.nextReport()) state = REPORTING_STATE; // We want to report on the interval boundary
+    if (connection.failures() >= connectFailuresBeforeReset) {          // The backoff has not helped - let the error state reset us
+      resetTimeStamp = millis();
+      state = ERROR_STATE;
     }
-    state = IDLE_STATE;                                                 // Go back to IDLE to make sure housekeeping is done
-  } break;
+    if (stateOfCharge <= lowBattLimit) state = LOW_BATTERY_STATE;        // The battery is low - sleep
+    samplePolicy.inputs(readInputs());                                  // A change on any input makes a measurement due now
+    if (samplePolicy.due()) takeMeasurements();                         // Every second while active, backing off to 30 seconds when quiet
+    break;
 
   case LOW_BATTERY_STATE: {
     if (verboseMode && state != oldState) publishStateTransition();
-      Log.info("Low Battery - sleeping");
-      if (Particle.connected()) disconnectFromParticle();               // If connected, we need to disconned and power down the modem
       digitalWrite(blueLED,LOW);                                        // Turn off the LED
       digitalWrite(pumpControlPin,LOW);                                 // Turn off the pump as we cannot monitor in our sleep
+      connection.disconnect();                                          // We need to disconnect and power down the modem - takes a few passes
+      if (!connection.off()) break;
+      Log.info("Low Battery - sleeping");
       digitalWrite(tmp36Shutdwn, LOW);                                  // Turns off the temp sensor
       int secondsToHour = (60*(60 - Time.minute()));                    // Time till the top of the hour
       System.sleep(SLEEP_MODE_DEEP,secondsToHour);                      // Very deep sleep till the next hour - then resets
@@ -300,59 +438,65 @@ void loop()
 
   case REPORTING_STATE: 
     if (verboseMode && state != oldState) publishStateTransition();
+    queueReport();                                                      // Saved to FRAM first so it is not lost if the send fails
     if (Particle.connected()) {
       if (alertValue != 0)  resolveAlert();
       petWatchdog();                                                    // Proactively pet the watchdog
-      sendEvent();                                                      // Send data to Ubidots
+      sendEvent();                                                      // Send the oldest queued report to Ubidots
       state = RESP_WAIT_STATE;                                          // Wait for Response
     }
-    else state = ERROR_STATE;
+    else state = IDLE_STATE;                                            // The report waits in FRAM - the connection manager is already retrying
     break;
 
   case RESP_WAIT_STATE:
     if (verboseMode && state != oldState) publishStateTransition();
-    if (!dataInFlight) {
-      if (Time.hour() == 2 && Time.isValid()) DSTRULES() ? Time.beginDST() : Time.endDST();    // Each day, at 2am we will check to see if we need a DST offset
-      if (Time.hour() == 0) dailyCleanup();                                                    // Each day at midnight, we need to clean up and zero counts
+    if (Particle.connected() && !deliveries.full() && reportQueue.size() > deliveries.reports() && publishQueue.accepts(PublishQueue::TELEMETRY)) {
+      sendEvent();                                                      // More reports queued - send the next without waiting on the responses
+    }
+    else if (deliveries.empty()) {
+      if (Time.isValid() && Time.now() >= reportSchedule.nextDSTCheck()) {  // Each day, at 2am we will check to see if we need a DST offset
+        if (reportSchedule.dstCheckTaken()) {                           // Skipped if we missed 2am by more than an hour
+          DSTRULES() ? Time.beginDST() : Time.endDST();
+          reportSchedule.recompute();                                   // Local time may have moved an hour
+          fram.put<FRAM::CleanupDeadline>((uint32_t)reportSchedule.nextCleanup());
+        }
+      }
+      if (Time.isValid() && Time.now() >= reportSchedule.nextCleanup()) {  // Each day at midnight, we need to clean up and zero counts
+        reportSchedule.cleanupTaken();                                  // Even if we are hours late - the day's counts still need zeroing
+        dailyCleanup();
+      }
       state = IDLE_STATE;                                               // Response received
     }
-    else if (millis() - webhookTimeStamp >= webhookWait) {              // If it takes too long - will need to reset
+    else if (deliveries.timedOut(webhookWait)) {                        // If it takes too long - will need to reset
       resetTimeStamp = millis();
-      if (verboseMode) {
-        waitUntil(meterParticlePublish);
-        Particle.publish("State","Response Timeout Error",PRIVATE);
-      }
+      if (verboseMode) publishQueue.publish("State","Response Timeout Error",PublishQueue::VERBOSE);
       state = ERROR_STATE;                                              // Response timed out
     }
     break;
 
     case ERROR_STATE: {                                                 // Here is where we deal with errors
       if (verboseMode && state != oldState) publishStateTransition();
-      unsigned long lastWebHookResponse;
-      fram.get(FRAM::lastHookResponseAddr,lastWebHookResponse);
+      unsigned long lastWebHookResponse = framCache.get<FRAM::LastHookResponse>();
       if (millis() - resetTimeStamp >= resetWait)
       {
         if (resetCount <= 3) {                                          // First try simple reset
-          waitUntil(meterParticlePublish);
-          if (Particle.connected()) Particle.publish("State","Error State - Reset", PRIVATE);    // Brodcast Reset Action
+          if (Particle.connected()) publishQueue.publish("State","Error State - Reset", PublishQueue::ALERT);    // Brodcast Reset Action
           Log.info("Error State - Reset");
-          delay(2000);
+          publishQueue.flush(5000);                                     // Give the announcement a chance to go out before we reset
           System.reset();
         }
         else if (Time.now() - lastWebHookResponse > 7200L) {            //It has been more than two hours since a sucessful hook response
-          waitUntil(meterParticlePublish);
-          if (Particle.connected()) Particle.publish("State","Error State - Power Cycle", PRIVATE);  // Broadcast Reset Action
+          if (Particle.connected()) publishQueue.publish("State","Error State - Power Cycle", PublishQueue::ALERT);  // Broadcast Reset Action
           Log.info("Error State - Power Cycle");
-          delay(2000);
-          fram.put(FRAM::resetCountAddr,0);                             // Zero the ResetCount
+          publishQueue.flush(5000);                                     // Give the announcement a chance to go out before we reset
+          framCache.put<FRAM::ResetCount>(0);                           // Zero the ResetCount
           digitalWrite(hardResetPin,HIGH);                              // This will cut all power to the Electron AND the carrier board
         }
         else {                                                          // If we have had 3 resets - time to do something more
-          waitUntil(meterParticlePublish);
-          if (Particle.connected()) Particle.publish("State","Error State - Full Modem Reset", PRIVATE);            // Brodcase Reset Action
+          if (Particle.connected()) publishQueue.publish("State","Error State - Full Modem Reset", PublishQueue::ALERT);            // Brodcase Reset Action
           Log.info("Error State - Full Modem Reset");
-          delay(2000);
-          fram.put(FRAM::resetCountAddr,0);                             // Zero the ResetCount
+          publishQueue.flush(5000);                                     // Give the announcement a chance to go out before we reset
+          framCache.put<FRAM::ResetCount>(0);                           // Zero the ResetCount
           fullModemReset();                                             // Full Modem reset and reboots
         }
       }
@@ -360,8 +504,37 @@ void loop()
   }
 }
 
-void pumpTimerCallback() { 
-  pumpCalled = false; 
+void applyPumpCommands() {                                              // The only writer of pumpCalled - commands are applied in the order they were posted
+  CommandMailbox::Command command;
+  while (pumpCommands.take(command)) {
+    pumpCalled = command.value;                                         // The last one posted wins
+    pumpCommand = command;
+    if (command.source == CommandMailbox::SUBSCRIPTION) {               // Acknowledged here as the publish queue belongs to loop()
+      publishQueue.publish("Status", command.value ? "Pump On Received" : "Pump Off Received",PublishQueue::CONTROL_ACK,true);
+    }
+    Log.info("Pump %s from %s (#%lu)", command.value ? "on" : "off", CommandMailbox::sourceName(command.source), (unsigned long)command.seq);
+  }
+}
+
+void actuatePump() {                                                    // Runs on every pass - the interlocks are checked here and nowhere else
+  bool on = digitalRead(pumpControlPin);
+  if (!on && pumpCalled && !pumpLockOut && state != LOW_BATTERY_STATE) {  // Not if locked out or about to sleep
+    digitalWrite(pumpControlPin,HIGH);
+    digitalWrite(blueLED,HIGH);
+    if (!pumpFailsafe.armed()) pumpFailsafe.arm();                      // Already armed if this run was resumed after a reset
+  }
+  else if (on && !pumpCalled) {
+    digitalWrite(pumpControlPin,LOW);
+    digitalWrite(blueLED,LOW);
+    pumpFailsafe.disarm();
+  }
+  else return;
+
+  char data[96];
+  pumpLatencyMs = millis() - pumpCommand.postedAt;
+  snprintf(data, sizeof(data), "{\"pump\":%i, \"seq\":%lu, \"source\":\"%s\", \"latencyMs\":%i}", !on, (unsigned long)pumpCommand.seq, CommandMailbox::sourceName(pumpCommand.source), pumpLatencyMs);
+  publishQueue.publish("Pump", data, PublishQueue::CONTROL_ACK);
+  Log.info("Pump turned %s %i mSec after command #%lu", on ? "off" : "on", pumpLatencyMs, (unsigned long)pumpCommand.seq);
 }
 
 void resolveAlert() {                                                   // This function takes the AlertValue and publishes a message
@@ -370,65 +543,140 @@ void resolveAlert() {                                                   // This
   if (alertValue & 0b00000010) strcat(data,"Low Level - ");
   if (alertValue & 0b00000100) strcat(data,"Pump On - ");
   if (alertValue & 0b10000000) strcat(data,"Particle Power");
-  waitUntil(meterParticlePublish);
-  if(Particle.connected()) Particle.publish("Alerts",data,PRIVATE);
+  if(Particle.connected()) publishQueue.publish("Alerts",data,PublishQueue::ALERT,true);  // Only the latest alert matters if one is still waiting
 }
 
-void sendEvent() {
-  char data[256];                                                       // Store the date in this character array - not global
-  snprintf(data, sizeof(data), "{\"alertValue\":%i, \"pumpAmps\":%i, \"pumpMins\":%i, \"battery\":%i, \"temp\":%i, \"resets\":%i}",alertValue, pumpAmps, dailyPumpingMins, stateOfCharge, temperatureF,resetCount);
-  waitUntil(meterParticlePublish);
-  Particle.publish("Monitoring_Event", data, PRIVATE);
+void queueReport() {                                                    // Takes a report of the current values and adds it to the FRAM queue
+  MonitoringReport report = {};
+  report.timestamp = Time.now();
+  report.pumpAmps = pumpAmps;
+  report.pumpMins = dailyPumpingMins;
+  report.temp = temperatureF;
+  report.resets = resetCount;
+  report.alertValue = alertValue;
+  report.battery = stateOfCharge;
+  signalCache.refreshIfOlderThan(60000);                                // Fresh reading for the report unless we have a recent one
+  const SignalCache::Window &strength = signalCache.strengthWindow();
+  const SignalCache::Window &quality = signalCache.qualityWindow();
+  if (strength.count) report.signal = strength.mean();                 // Mean over the window
+  else if (signalCache.valid()) report.signal = signalCache.strength(); // No reading since the last report - use the latest
+  if (quality.count) report.quality = quality.mean();
+  else if (signalCache.valid()) report.quality = signalCache.quality();
+  signalCache.startWindow();
+  getSignalStrength();
+  RunningStats *windows[] = {&ampsStats, &temperatureStats, &batteryStats};
+  WindowSummary *summaries[] = {&report.ampsWindow, &report.tempWindow, &report.batteryWindow};
+  for (size_t i = 0; i < 3; i++) {                                      // Already in the tenths the report keeps - left zero if nothing was sampled
+    if (windows[i]->count()) {
+      summaries[i]->min = windows[i]->min();
+      summaries[i]->max = windows[i]->max();
+      summaries[i]->mean = windows[i]->mean();
+      summaries[i]->stddev = windows[i]->stddev();
+    }
+    windows[i]->clear();                                                // The next window starts now
+  }
+  report.seq = nextReportSeq++;
+  fram.put<FRAM::ReportSequence>(nextReportSeq);
+  if (!reportQueue.push(report)) Log.info("Report queue write failed"); // If full, the oldest report is dropped
+  reportSchedule.reportTaken();                                         // Change the time period since we have reported for this one 
+}
+
+bool sendEvent() {                                                      // Sends the oldest queued report not already in flight - it is removed when the webhook responds
+  MonitoringReport report;
+  size_t index = 0;
+  for (; ; index++) {                                                   // The ones in flight are at the front of the queue
+    if (deliveries.full() || !reportQueue.peek(report, index)) return false;
+    if (!deliveries.contains(report.seq)) break;
+  }
+  char data[PublishQueue::DATA_SIZE];                                   // Store the date in this character array - not global
+  uint32_t lastSeq = report.seq;
+  uint16_t reports = 1;
+  if (binaryReports && reportQueue.size() > index + 1) {                // A backlog - as many as fit go in one publish, answered by the first seq
+    uint8_t packed[ReportCodec::Batch::maxLength(sizeof(data))];        // What armors into data - about 17 reports
+    ReportCodec::Batch batch(packed, sizeof(packed));
+    MonitoringReport next = report;
+    while (batch.add(next)) {
+      lastSeq = next.seq;
+      if (!reportQueue.peek(next, index + batch.count())) break;
+    }
+    reports = batch.count();
+    ReportCodec::armor(packed, batch.length(), data, sizeof(data));
+  }
+  else if (deltaReports && haveDeltaBase && report.seq - keyframeSeq < keyframeInterval) {
+    ReportCodec::encodeDeltaText(report, deltaBase, data, sizeof(data));  // A steady site sends little more than the seq and the signal
+  }
+  else if (binaryReports) {
+    ReportCodec::encodeText(report, data, sizeof(data));                // The seq is in the record for the response template
+    keyframeSeq = report.seq;
+  }
+  else {
+    const WindowSummary &amps = report.ampsWindow, &temp = report.tempWindow, &battery = report.batteryWindow;  // Tenths, as in the binary record
+    snprintf(data, sizeof(data), "{\"seq\":%lu, \"alertValue\":%i, \"pumpAmps\":%i, \"pumpMins\":%i, \"battery\":%i, \"temp\":%i, \"resets\":%i, \"signal\":%i, \"quality\":%i, "
+      "\"ampsWindow\":{\"min\":%i, \"max\":%i, \"mean\":%i, \"stddev\":%i}, \"tempWindow\":{\"min\":%i, \"max\":%i, \"mean\":%i, \"stddev\":%i}, "
+      "\"batteryWindow\":{\"min\":%i, \"max\":%i, \"mean\":%i, \"stddev\":%i}, \"timestamp\":%lu000}",
+      (unsigned long)report.seq, report.alertValue, report.pumpAmps, report.pumpMins, report.battery, report.temp, report.resets, report.signal, report.quality,
+      amps.min, amps.max, amps.mean, amps.stddev, temp.min, temp.max, temp.mean, temp.stddev, battery.min, battery.max, battery.mean, battery.stddev, (unsigned long)report.timestamp);
+  }
+  if (!publishQueue.publish("Monitoring_Event", data, PublishQueue::TELEMETRY, false, report.seq)) return false;  // No room - no response will come, so it is not in flight
   Log.info(data);
-  webhookTimeStamp = millis();
-  currentHourlyPeriod = Time.hour();                                    // Change the time period since we have reported for this one 
-  dataInFlight = true;                                                  // set the data inflight flag
+  deliveries.sent(report.seq, lastSeq, reports);                        // Starts its response timeout
+  return true;
+}
+
+void publishDropped(const char *name, uint32_t tag) {                   // A queued publish made room for a more important one
+  if (strcmp(name, "Monitoring_Event") == 0) deliveries.cancel(tag);    // Never sent - the tag is the first seq, so it goes out again
 }
 
 void UbidotsHandler(const char *event, const char *data) { // Looks at the response from Ubidots - Will reset Photon if no successful response
-  // Response Template: "{{hourly.0.status_code}}"
+  // Response Template: "<seq>:{{hourly.0.status_code}}" - the webhook echoes the seq from the Monitoring_Event data, the first one for a batch
   if (!data) {                                                          // First check to see if there is any data
-    waitUntil(meterParticlePublish);
-    Particle.publish("Ubidots Hook", "No Data",PRIVATE);
+    publishQueue.publish("Ubidots Hook", "No Data",PublishQueue::ALERT);
     return;
   }
-  int responseCode = atoi(data);                                        // Response is only a single number thanks to Template
+  char *end;
+  uint32_t seq = strtoul(data, &end, 10);
+  bool hasSeq = (*end == ':' && end != data);
+  int responseCode = hasSeq ? atoi(end + 1) : atoi(data);               // A bare status code is the old template
+  if (fram.isFillBusy()) return;                                        // Reset-FRAM is emptying the queue - nothing left to release
   if ((responseCode == 200) || (responseCode == 201)) {
-    if (verboseMode) {
-      waitUntil(meterParticlePublish);
-      Particle.publish("State","Response Received",PRIVATE);
-    }
-    fram.put(FRAM::lastHookResponseAddr,Time.now());                    // Keep track of last hook response
-    dataInFlight = false;                                               // Data has been received
+    if (verboseMode) publishQueue.publish("State","Response Received",PublishQueue::VERBOSE);
+    framCache.put<FRAM::LastHookResponse>(Time.now());                  // Keep track of last hook response
+    bool matched = hasSeq ? deliveries.ack(seq) : deliveries.ackOldest();
+    if (!matched) Log.info("Response for report %lu is not in flight - ignored", (unsigned long)seq);  // Late or duplicate - must not clear another report
+    releaseDelivered();
   }
   else {
-    waitUntil(meterParticlePublish);
-    Particle.publish("Ubidots Hook", data, PRIVATE);                    // Publish the response code
+    publishQueue.publish("Ubidots Hook", data, PublishQueue::ALERT);    // Publish the response code
   }
 }
 
+void releaseDelivered() {                                               // Acknowledged reports leave the FRAM queue in order, oldest first
+  MonitoringReport report;
+  while (reportQueue.peek(report) && deliveries.acked(report.seq)) {
+    reportQueue.pop();                                                  // Delivered - only now is it removed from FRAM
+    deliveries.forget(report.seq);
+    deltaBase = report;                                                 // The webhook has it - the next deltas can build on it
+    haveDeltaBase = true;
+  }
+  if (reportQueue.empty()) deliveries.clear();
+  else deliveries.forgetBefore(report.seq);                             // A full queue drops its oldest report, even one in flight
+}
 
-void getSignalStrength() {
-  // New Signal Strength capability - https://community.particle.io/t/boron-lte-and-cellular-rssi-funny-values/45299/8
-  CellularSignal sig = Cellular.RSSI();
-  auto rat = sig.getAccessTechnology();
- 
-  //float strengthVal = sig.getStrengthValue();
-  float strengthPercentage = sig.getStrength();
-
-  //float qualityVal = sig.getQualityValue();
-  float qualityPercentage = sig.getQuality();
 
-  snprintf(SignalString,sizeof(SignalString), "%s S:%2.0f%%, Q:%2.0f%% ", radioTech[rat], strengthPercentage, qualityPercentage);
+void getSignalStrength() {                                              // Formats the cached reading - no modem traffic
+  // New Signal Strength capability - https://community.particle.io/t/boron-lte-and-cellular-rssi-funny-values/45299/8
+  if (!signalCache.valid()) return;
+  const SignalCache::Window &strength = signalCache.strengthWindow();
+  const SignalCache::Window &quality = signalCache.qualityWindow();
+  if (strength.count) snprintf(SignalString,sizeof(SignalString), "%s S:%i%% (%i-%i), Q:%i%% (%i-%i)", radioTech[signalCache.accessTechnology()], signalCache.strength(), strength.min, strength.max, signalCache.quality(), quality.min, quality.max);
+  else snprintf(SignalString,sizeof(SignalString), "%s S:%i%%, Q:%i%% ", radioTech[signalCache.accessTechnology()], signalCache.strength(), signalCache.quality());
 }
 
-int getTemperature() {
+int getTemperature() {                                                  // Returns tenths - temperatureF is rounded to whole degrees
   int reading = analogRead(tmp36Pin);                                   //getting the voltage reading from the temperature sensor
-  float voltage = reading * 3.3;                                        // converting that reading to voltage, for 3.3v arduino use 3.3
-  voltage /= 4096.0;                                                    // Electron is different than the Arduino where there are only 1024 steps
-  int temperatureC = int(((voltage - 0.5) * 100));                      //converting from 10 mv per degree with 500 mV offset to degrees ((voltage - 500mV) times 100) - 5 degree calibration
-  temperatureF = int((temperatureC * 9.0 / 5.0) + 32.0);                // now convert to Fahrenheit
-  return temperatureF;
+  int tenths = tempCalibration.lookup(reading);                         // Table is in tenths of a degree F - see Calibration::TMP36
+  temperatureF = Calibration::roundTenths(tenths);
+  return tenths;
 }
 
 // Here is were we will put the timer and other ISRs
@@ -443,31 +691,21 @@ void petWatchdog() {
 }
 
 // These functions manage our connecion to Particle
-bool connectToParticle() {
-  if (!Cellular.ready())
-  {
-    Cellular.on();                                                      // turn on the Modem
-    Cellular.connect();                                                 // Connect to the cellular network
-    if(!waitFor(Cellular.ready,90000)) return false;                    // Connect to cellular - give it 90 seconds
-  }
-  Particle.process();
-  Particle.connect();                                                   // Connect to Particle
-  if(!waitFor(Particle.connected,30000)) return false;                  // Connect to Particle - give it 30 seconds
-  Particle.process();
-  return true;
-}
-
-bool disconnectFromParticle() {
-  Particle.disconnect();                                                // Disconnect from Particle in prep for sleep
-  waitFor(notConnected,10000);
-  Cellular.disconnect();                                                // Disconnect from the cellular network
-  delay(3000);
-  Cellular.off();                                                       // Turn off the cellular modem
-  return true;
+void connectionChanged() {                                              // Called from loop() each time an attempt connects or fails
+  saveConnectionStats();
+  if (connection.connected() && !clockSet) {
+    clockSet = true;
+    DSTRULES() ? Time.beginDST() : Time.endDST();                       // Could not be worked out without the date
+    reportSchedule.begin(reportSchedule.getInterval(), fram.get<FRAM::CleanupDeadline>());  // The clock was just synced - start the schedule over from the real time
+  }
 }
 
-bool notConnected() {
-  return !Particle.connected();                                         // This is a requirement to use waitFor
+void saveConnectionStats() {
+  if (fram.isFillBusy()) return;                                        // Saved again once Reset-FRAM is done
+  ConnectionManager::Stats stats = connection.stats();
+  stats.seal();
+  fram.put<FRAM::ConnectStats>(stats);
+  connection.format(connectionString, sizeof(connectionString));
 }
 
 
@@ -475,43 +713,64 @@ bool notConnected() {
 void takeMeasurements() {
   static byte lastAlertValue = 0;                                       // Last value - so we can detect a change
   static int lastPumpAmps = 0;                                          // Need to make sure we are reporting signficant changes here
-  fram.get(FRAM::controlRegisterAddr, controlRegister);                 // Check out the control register
+  controlRegister = framCache.get<FRAM::ControlRegister>();             // Check out the control register
   bool pumpAmpsSignificantChange = false;                               // Don't want to waste bandwidth reporting small changes
 
   // Gather the measurements
-  if (Cellular.ready()) getSignalStrength();                            // Test signal strength if the cellular modem is on and ready
-  getTemperature();                                                     // Get Temperature at startup as well
-  stateOfCharge = int(batteryMonitor.getSoC());                         // Percentage of full charge
-  pumpCurrentRaw = analogRead(pumpCurrentPin);                          // Current sensor is fairly linear from 1 to 32 Amps
-  pumpAmps = map(pumpCurrentRaw,0,4095,0,32);                           // Map analog voltage to current
+  if (signalCache.loop()) getSignalStrength();                          // Only talks to the modem every few minutes
+  int temperatureTenths = getTemperature();                             // Get Temperature at startup as well
+  float charge = batteryMonitor.getSoC();
+  stateOfCharge = int(charge);                                          // Percentage of full charge
+  pumpCurrentSampler.sample();                                          // 33 ms burst so we do not catch a random point on the waveform
+  pumpCurrentRaw = pumpCurrentSampler.rms();                            // Current sensor is fairly linear from 1 to 32 Amps
+  int ampsTenths = currentCalibration.lookup(pumpCurrentRaw);           // Table is in tenths of an amp
+  pumpAmps = Calibration::roundTenths(ampsTenths);
+
+  // Add to the window statistics - weighted by the time since the last measurement, as the sample rate varies
+  unsigned long elapsed = millis() - statsSampledAt;
+  if (!statsSampledAt || elapsed >= 2 * SamplePolicy::SLOW_MS) elapsed = SamplePolicy::IDLE_MS;  // The first after a boot or a stall counts as one idle interval
+  uint32_t weight = (elapsed + 50) / 100;                               // Tenths of a second - see RunningStats
+  if (!weight) weight = 1;
+  statsSampledAt = millis();
+  ampsStats.add(ampsTenths, weight);
+  temperatureStats.add(temperatureTenths, weight);
+  batteryStats.add((int16_t)(charge * 10.0f + 0.5f), weight);           // The fuel gauge only gives a float
   if (pumpAmps >= lastPumpAmps + 2 || pumpAmps <= lastPumpAmps - 2) pumpAmpsSignificantChange = true;
 
   // Build the Alert Value
   alertValue = 0b00000000;                                              // Reset for each run through
-  if (!pinReadFast(controlPowerPin)) alertValue = alertValue | 0b00000001;      // Set the value for alertValue - This is opposite - power is good
-  if (!pinReadFast(lowLevelPin)) alertValue = alertValue | 0b00000010;  // Set the value for alertValue
+  if (edgeCapture.held(controlPowerInput, LOW)) alertValue = alertValue | 0b00000001;  // Power was lost at some point since the last measurement - This is opposite - power is good
+  if (edgeCapture.held(lowLevelInput, LOW)) alertValue = alertValue | 0b00000010;      // Level was low at some point since the last measurement
+  edgeCapture.clearHeld();
   if (pumpCalled)                                                   // If the pump is on
   {
     alertValue = alertValue | 0b00000100;                               // Set the value for alertValue
     if (!(controlRegister & 0b00000010)) {                              // This is a new pumping session
       pumpingStart = Time.now();
-      fram.put(FRAM::pumpingStartAddr,pumpingStart);                    // Write to FRAM in case of a reset
-      fram.put(FRAM::controlRegisterAddr, controlRegister | 0b00000010);// Turn on the pumping bit
+      FRAM::PumpingSession::store(framCache, controlRegister | 0b00000010, pumpingStart); // Turn on the pumping bit and save the start in case of a reset
     }
   }
   else if (controlRegister & 0b00000010) {                              // If the pump is off but the pumping flag is set
-    fram.put(FRAM::controlRegisterAddr, controlRegister ^ 0b00000010);  // It is on and I want to turn the pumping bit off with an xor
     time_t pumpingStop = Time.now();
     dailyPumpingMins += int(difftime(pumpingStop,pumpingStart)/60);     // Add to the total for the day
-    fram.put(FRAM::dailyPumpingMinsAddr,dailyPumpingMins);              // Store it in FRAM in case of a reset
+    FRAM::PumpingTotals::store(framCache, controlRegister ^ 0b00000010, dailyPumpingMins);  // Pumping bit off with an xor, store the total in case of a reset
   }
   if (System.powerSource() == 5) alertValue = alertValue | 0b10000000;  // Set the value for alertValue if we are on battery power
 
   if (alertValue != lastAlertValue || pumpAmpsSignificantChange) state = REPORTING_STATE;
+  samplePolicy.sampled(state == REPORTING_STATE || pumpAmps > 0 || digitalRead(pumpControlPin));
   lastAlertValue = alertValue;
   lastPumpAmps = pumpAmps;
 }
 
+uint8_t readInputs() {                                                  // The inputs as last seen - nothing here touches a bus or the ADC
+  uint8_t bits = 0;
+  if (edgeCapture.level(controlPowerInput)) bits |= 0b00000001;       // Debounced levels kept by the pin interrupts
+  if (edgeCapture.level(lowLevelInput)) bits |= 0b00000010;
+  if (pinReadFast(pumpControlPin)) bits |= 0b00000100;                 // The output, not pumpCalled - measures once the relay has switched
+  return bits;
+}
+
 
 /* These are the particle functions that allow you to configure and run the device
  * They are intended to allow for customization and control during installations
@@ -520,28 +779,23 @@ void takeMeasurements() {
 
 int pumpControl(String command)                                         // This is the API end point to turn the pump on and off
 {
-  if (command == "1") {
-    pumpCalled = true;
-    return 1;
-  }
-  else if (command == "0") {
-    pumpCalled = false;
-    return 1;
-  }
+  if (command == "1") return pumpCommands.post(CommandMailbox::FUNCTION, 1);  // 0 back to the caller if the mailbox is full
+  else if (command == "0") return pumpCommands.post(CommandMailbox::FUNCTION, 0);
   else return 0;
 }
 
 int setPumpLockout(String command) {                                        // This is a way to esnure the pump will not pump even when called
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
   if (command == "1") {
-    Particle.publish("Lockout","True",PRIVATE);
+    publishQueue.publish("Lockout","True",PublishQueue::CONTROL_ACK,true);
     pumpLockOut = true;
-    fram.put(FRAM::pumpingLockoutAddr,pumpLockOut);
+    framCache.put<FRAM::PumpingLockout>(pumpLockOut);
     return 1;
   }
   else if (command == "0") {
-    Particle.publish("Lockout","False",PRIVATE);
+    publishQueue.publish("Lockout","False",PublishQueue::CONTROL_ACK,true);
     pumpLockOut = false;
-    fram.put(FRAM::pumpingLockoutAddr,pumpLockOut);
+    framCache.put<FRAM::PumpingLockout>(pumpLockOut);
     return 1;
   }
   else return 0;
@@ -550,21 +804,53 @@ int setPumpLockout(String command) {                                        // T
 
 int resetFRAM(String command)                                           // Will reset the local counts
 {
-  if (command == "1") {
-    fram.erase();
+  if (command == "1" && !fram.isFillBusy()) {
+    fram.startErase();                                                  // Erase runs in the background from IDLE_STATE so we return right away
     return 1;
   }
   else return 0;
 }
 
+void eraseFRAMProcess() {                                               // Erases a bounded slice of FRAM each pass so the watchdog still gets petted
+  if (!fram.fillProcess()) Log.info("FRAM erase failed");
+  else if (!fram.isFillBusy()) {                                        // Everything is read back as it would be after a reset - only a pumping run carries on
+    bool pumping = controlRegister & 0b00000010;                        // Still the value from before the erase
+    framCache.reload();                                                 // The cached region was erased behind the cache's back
+    framCache.put<FRAM::Version>(FRAMMEMORYMAPVERSION);
+    reportQueue.begin();                                                // The queue was erased too - starts over empty
+    deliveries.clear();
+    haveDeltaBase = false;                                              // The sequence starts over - the webhook's copy is no base for it
+    nextReportSeq = fram.get<FRAM::ReportSequence>();
+    loadCalibration();                                                  // Back to the built in tables
+    connection.clearStats();
+    saveConnectionStats();
+    resetCount = framCache.get<FRAM::ResetCount>();
+    dailyPumpingMins = framCache.get<FRAM::DailyPumpingMins>();
+    pumpLockOut = framCache.get<FRAM::PumpingLockout>();
+    controlRegister = framCache.get<FRAM::ControlRegister>();
+    verboseMode = (0b00001000 & controlRegister);
+    binaryReports = (0b00010000 & controlRegister);
+    deltaReports = (0b00100000 & controlRegister);
+    if (pumping) {                                                      // The relay is on and the failsafe armed - saved again so a reset resumes the run with the same budget
+      controlRegister |= 0b00000010;
+      FRAM::PumpingSession::store(framCache, controlRegister, pumpingStart);
+    }
+    loadTimeZone();
+    reportSchedule.begin(framCache.get<FRAM::ReportInterval>(), reportSchedule.nextCleanup());  // Reports right away - the first of the new queue
+    fram.put<FRAM::CleanupDeadline>((uint32_t)reportSchedule.nextCleanup());
+    Log.info("FRAM erase complete");
+  }
+  else if (verboseMode) Log.info("FRAM erase %i%%", fram.getFillProgress());
+}
+
 int resetCounts(String command)                                         // Resets the current hourly and daily counts
 {
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
   if (command == "1") {
-    fram.put(FRAM::resetCountAddr,0);                                   // If so, store incremented number - watchdog must have done This
+    FRAM::Counts::store(framCache, 0, 0);                               // One bus session for both counts
     resetCount = 0;
-    dataInFlight = false;
+    deliveries.clear();
     dailyPumpingMins = 0;
-    fram.put(FRAM::dailyPumpingMinsAddr,0);
     alertValue = 0;
     return 1;
   }
@@ -591,43 +877,51 @@ int sendNow(String command)                                             // Funct
 
 int setVerboseMode(String command)                                      // Function to force sending data in current hour
 {
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
   if (command == "1") {
     verboseMode = true;
-    fram.get(FRAM::controlRegisterAddr,controlRegister);
+    controlRegister = framCache.get<FRAM::ControlRegister>();
     controlRegister = (0b00001000 | controlRegister);                   // Turn on verboseMode
-    fram.put(FRAM::controlRegisterAddr, controlRegister);               // Write it to the register
-    waitUntil(meterParticlePublish);
-    Particle.publish("Mode","Set Verbose Mode",PRIVATE);
+    framCache.put<FRAM::ControlRegister>(controlRegister);              // Write it to the register
+    publishQueue.publish("Mode","Set Verbose Mode",PublishQueue::CONTROL_ACK,true);
     return 1;
   }
   else if (command == "0") {
     verboseMode = false;
-    fram.get(FRAM::controlRegisterAddr,controlRegister);
+    controlRegister = framCache.get<FRAM::ControlRegister>();
     controlRegister = (0b11110111 & controlRegister);                   // Turn off verboseMode
-    fram.put(FRAM::controlRegisterAddr, controlRegister);               // Write it to the register
-    waitUntil(meterParticlePublish);
-    Particle.publish("Mode","Cleared Verbose Mode",PRIVATE);
+    framCache.put<FRAM::ControlRegister>(controlRegister);              // Write it to the register
+    publishQueue.publish("Mode","Cleared Verbose Mode",PublishQueue::CONTROL_ACK,true);
     return 1;
   }
   else return 0;
 }
 
-bool meterParticlePublish(void) {
-  static unsigned long lastPublish = 0;                                 // Keep track of when we publish a webhook
-  if(millis() - lastPublish >= 1000) {
-    lastPublish = millis();
-    return 1;
+int setReportFormat(String command)                                     // Binary needs a webhook that decodes it - JSON goes straight to Ubidots
+{
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
+  byte formatBits;
+  const char *message;
+  if (command == "json") {
+    formatBits = 0b00000000;
+    message = "Set JSON Reports";
   }
-  else return 0;
-}
-
-bool meterSampleRate(void) {
-  static unsigned long lastSample = 0;
-  if(millis() - lastSample >= sampleFrequency) {
-    lastSample = millis();
-    return 1;
+  else if (command == "binary") {
+    formatBits = 0b00010000;
+    message = "Set Binary Reports";
+  }
+  else if (command == "delta") {                                        // Binary, and only the fields that changed since the last acknowledged report
+    formatBits = 0b00110000;
+    message = "Set Delta Reports";
   }
   else return 0;
+  binaryReports = (0b00010000 & formatBits);
+  deltaReports = (0b00100000 & formatBits);
+  controlRegister = framCache.get<FRAM::ControlRegister>();
+  controlRegister = (0b11001111 & controlRegister) | formatBits;        // Both format bits at once
+  framCache.put<FRAM::ControlRegister>(controlRegister);                // Write it to the register
+  publishQueue.publish("Mode",message,PublishQueue::CONTROL_ACK,true);
+  return 1;
 }
 
 void fullModemReset() {  // Adapted form Rikkas7's https://github.com/rickkas7/electronsample
@@ -648,66 +942,131 @@ void pumpControlHandler(const char *event, const char *data)
 {
   char * pEND;
   int onOrOff = strtol(data,&pEND,10);
-  if (onOrOff == 1) {
-    pumpCalled = true;
-    waitUntil(meterParticlePublish);
-    Particle.publish("Status", "Pump On Received",PRIVATE);
-  }
-  else if (onOrOff == 0) {
-    pumpCalled = false;
-    waitUntil(meterParticlePublish);
-    Particle.publish("Status", "Pump Off Received",PRIVATE);
+  if (onOrOff == 1 || onOrOff == 0) {
+    if (!pumpCommands.post(CommandMailbox::SUBSCRIPTION, onOrOff)) Log.info("Pump command mailbox full");
   }
 }
 
 
 void dailyCleanup() {                                                   // Function to clean house at the end of the day
-  fram.get(FRAM::controlRegisterAddr,controlRegister);
+  controlRegister = framCache.get<FRAM::ControlRegister>();
 
-  waitUntil(meterParticlePublish);
-  Particle.publish("Daily Cleanup","Running", PRIVATE);                 // Make sure this is being run
+  publishQueue.publish("Daily Cleanup","Running", PublishQueue::TELEMETRY);  // Make sure this is being run
+  publishQueue.publish("Connection", connectionString, PublishQueue::TELEMETRY);  // Yesterday's connect times - slow sites need antenna work
+  connection.clearStats();
+  saveConnectionStats();
 
   verboseMode = false;
   controlRegister = (0b11110111 & controlRegister);                     // Turn off verboseMode
 
   dailyPumpingMins = 0;                                                 // Zero for the day
-  fram.put(FRAM::dailyPumpingMinsAddr,0);
 
-  Particle.syncTime();                                                  // Set the clock each day
-  waitFor(Particle.syncTimeDone,30000);                                 // Wait for up to 30 seconds for the SyncTime to complete
+  FRAM::PumpingTotals::store(framCache, controlRegister, 0);            // One bus session for both fields
+  fram.put<FRAM::CleanupDeadline>((uint32_t)reportSchedule.nextCleanup());
 
-  fram.put(FRAM::controlRegisterAddr, controlRegister);
+  Particle.syncTime();                                                  // Set the clock each day - IDLE_STATE picks up the result
+  timeSyncPending = true;
 }
 
 void publishStateTransition(void) {                                     // Mainly for troubleshooting - publishes the transition between states
   char stateTransitionString[40];
   snprintf(stateTransitionString, sizeof(stateTransitionString), "From %s to %s", stateNames[oldState],stateNames[state]);
   if(Particle.connected()) {
-    waitUntil(meterParticlePublish);
-    Particle.publish("State Transition",stateTransitionString, PRIVATE);
+    publishQueue.publish("State Transition",stateTransitionString, PublishQueue::VERBOSE);
   }
   Log.info(stateTransitionString);
   oldState = state;
 }
 
 int setTimeZone(String command) {                                       // Set the Base Time Zone vs GMT - not Daylight savings time
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
   char * pEND;
   char data[256];
   time_t t = Time.now();
   int8_t tempTimeZoneValue = strtol(command,&pEND,10);                  // Looks for the first integer and interprets it
   if ((tempTimeZoneValue < -12) || (tempTimeZoneValue > 12)) return 0; // Make sure it falls in a valid range or send a "fail" result
   Time.zone((float)tempTimeZoneValue);
-  fram.put(FRAM::timeZoneAddr,tempTimeZoneValue);                       // Load the default value into FRAM for next time
+  framCache.put<FRAM::TimeZone>(tempTimeZoneValue);                     // Load the default value into FRAM for next time
   snprintf(data, sizeof(data), "Time base time zone is %i",tempTimeZoneValue);
-  waitUntil(meterParticlePublish);
   if (Time.isValid()) DSTRULES() ? Time.beginDST() : Time.endDST();     // Perform the DST calculation here 
   snprintf(currentOffsetStr,sizeof(currentOffsetStr),"%2.1f UTC",(Time.local() - Time.now()) / 3600.0);
-  if (Particle.connected()) Particle.publish("Time",data, PRIVATE);
-  waitUntil(meterParticlePublish);
-  if (Particle.connected()) Particle.publish("Time",Time.timeStr(t), PRIVATE);
+  reportSchedule.recompute();                                           // Report boundaries are in local time
+  fram.put<FRAM::CleanupDeadline>((uint32_t)reportSchedule.nextCleanup());
+  if (Particle.connected()) publishQueue.publish("Time",data, PublishQueue::CONTROL_ACK);
+  if (Particle.connected()) publishQueue.publish("Time",Time.timeStr(t).c_str(), PublishQueue::CONTROL_ACK);
+  return 1;
+}
+
+int setReportInterval(String command) {                                  // Report every 15, 30 or 60 minutes - stays aligned to the clock
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
+  char * pEND;
+  char data[64];
+  int intervalMins = strtol(command,&pEND,10);
+  if (!ReportSchedule::validInterval(intervalMins)) return 0;           // Only intervals that divide the hour evenly
+  reportSchedule.setInterval(intervalMins);
+  framCache.put<FRAM::ReportInterval>(intervalMins);                    // Keep it across resets
+  snprintf(data, sizeof(data), "Reporting every %i minutes", intervalMins);
+  if (Particle.connected()) publishQueue.publish("Mode",data,PublishQueue::CONTROL_ACK,true);
   return 1;
 }
 
+int setCalibration(String command) {                                    // "temp:raw=value,..." or "amps:raw=value,..." - "temp:default" goes back to the built in table
+  if (fram.isFillBusy()) return 0;                                      // Reset-FRAM is running - try again once it is done
+  char data[64];
+  const char *text = command.c_str();
+  bool isTemp = !strncmp(text, "temp:", 5);
+  if (!isTemp && strncmp(text, "amps:", 5)) return 0;
+  const char *points = text + 5;
+
+  CalibrationTable table = isTemp ? Calibration::TMP36 : Calibration::PUMP_CURRENT;
+  if (!strcmp(points, "default")) table.count = 0;                             // Stored as an empty table so the next boot uses the default too
+  else if (!table.parse(points)) return 0;
+  table.seal();
+  if (isTemp) fram.put<FRAM::TempCalibration>(table);
+  else fram.put<FRAM::CurrentCalibration>(table);
+  loadCalibration();
+
+  const CalibrationTable &active = isTemp ? tempCalibration : currentCalibration;
+  snprintf(data, sizeof(data), "%s calibration has %i points", isTemp ? "Temperature" : "Current", active.count);
+  if (Particle.connected()) publishQueue.publish("Calibration",data,PublishQueue::CONTROL_ACK);
+  return 1;
+}
+
+void loadTimeZone() {                                                   // From FRAM - at startup and after Reset-FRAM
+  int8_t tempTimeZoneValue = framCache.get<FRAM::TimeZone>();
+  if (tempTimeZoneValue > 12 || tempTimeZoneValue < -12) {
+    tempTimeZoneValue = -5;
+    framCache.put<FRAM::TimeZone>(tempTimeZoneValue);                   // Load the default value into FRAM for next time
+  }
+  Time.zone((float)tempTimeZoneValue);                                  // Implement the local time Zone value
+  if (Time.isValid()) DSTRULES() ? Time.beginDST() : Time.endDST();     // DST does not survive a reset - without it midnight is an hour off until the 2am check
+  snprintf(currentOffsetStr,sizeof(currentOffsetStr),"%2.1f UTC",(Time.local() - Time.now()) / 3600.0);
+}
+
+bool migrateFRAM(uint8_t version) {                                     // Moves the settings to where this layout keeps them - anything it cannot place starts over
+  CalibrationTable temp = {}, current = {};                             // Zeroed tables fail intact() - loadCalibration() then uses the built in ones
+  ConnectionManager::Stats stats = {};                                  // Likewise for restoreStats()
+  uint32_t sequence = 0, cleanup = 0;
+  if (version == 1) FRAMLegacy::V1::Settings::load(fram, temp, current, stats, sequence, cleanup);
+  else if (version == 2) FRAMLegacy::V2::Settings::load(fram, temp, current, stats, sequence, cleanup);
+  else if (version == 3) FRAMLegacy::V3::Settings::load(fram, temp, current, stats, sequence, cleanup);
+  if (version < 2) sequence = 0;                                        // Not kept yet - whatever is there is not ours
+  if (version < 3) cleanup = 0;
+  bool queueKept = version == 3 && sizeof(FRAMLegacy::V3::ReportQueue::Type) == sizeof(FRAM::ReportRing::Storage); // Same records - the undelivered ones move with the ring
+  if (queueKept) fram.moveData(FRAMLegacy::V3::ReportQueue::addr, FRAM::ReportQueue::addr, FRAM::ReportQueue::size);  // Overlapping, which moveData allows
+  FRAM::Settings::store(fram, temp, current, stats, sequence, cleanup); // After the move - the new settings sit where the old ring began
+  framCache.put<FRAM::Version>(FRAMMEMORYMAPVERSION);
+  Log.info("FRAM layout %i moved to %i", version, FRAMMEMORYMAPVERSION);
+  return queueKept;
+}
+
+void loadCalibration() {                                                // Uses the FRAM tables if they were written whole, the built in ones if not
+  CalibrationTable table = fram.get<FRAM::TempCalibration>();
+  tempCalibration = table.intact() ? table : Calibration::TMP36;
+  table = fram.get<FRAM::CurrentCalibration>();
+  currentCalibration = table.intact() ? table : Calibration::PUMP_CURRENT;
+}
+
 bool isDSTusa() { 
   // United States of America Summer Timer calculation (2am Local Time - 2nd Sunday in March/ 1st Sunday in November)
   // Adapted from @ScruffR's code posted here https://community.particle.io/t/daylight-savings-problem/38424/4
@@ -0,0 +1,46 @@
+#include "CommandMailbox.h"
+
+CommandMailbox::CommandMailbox() {
+  for (size_t i = 0; i < SIZE; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool CommandMailbox::post(Source source, uint8_t value) {
+  uint32_t pos = postPos.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot &slot = slots[pos % SIZE];
+    int32_t lag = (int32_t)(slot.sequence.load(std::memory_order_acquire) - pos);
+    if (lag == 0) {                                                     // Free - try to claim it
+      if (postPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        slot.command.seq = pos;
+        slot.command.postedAt = millis();
+        slot.command.source = source;
+        slot.command.value = value;
+        slot.sequence.store(pos + 1, std::memory_order_release);        // Hands it to take()
+        return true;
+      }                                                                 // Another thread got there first - pos now holds the new position
+    }
+    else if (lag < 0) {                                                 // Still holds a command from a lap ago - full
+      rejectedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else pos = postPos.load(std::memory_order_relaxed);
+  }
+}
+
+bool CommandMailbox::take(Command &command) {
+  Slot &slot = slots[takePos % SIZE];
+  if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (takePos + 1)) < 0) return false;  // Empty, or the next command is still being written
+  command = slot.command;
+  slot.sequence.store(takePos + SIZE, std::memory_order_release);       // Free for the next lap
+  takePos++;
+  return true;
+}
+
+const char *CommandMailbox::sourceName(uint8_t source) {
+  switch (source) {
+    case FUNCTION: return "function";
+    case SUBSCRIPTION: return "subscription";
+    case FAILSAFE: return "failsafe";
+    default: return "local";
+  }
+}
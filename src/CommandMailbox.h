@@ -0,0 +1,52 @@
+#ifndef __COMMANDMAILBOX_H
+#define __COMMANDMAILBOX_H
+
+#include "Particle.h"
+#include <atomic>
+
+// Hands pump on / off commands from the cloud handlers and the failsafe to loop(), which is the only
+// place that acts on them. With SYSTEM_THREAD(ENABLED) the Particle.function and Particle.subscribe
+// handlers still run on the application thread, between loop() passes, so they never race loop().
+// The producers that can interrupt a post are a software Timer (the failsafe was one) and ISRs.
+// Bounded multi producer / single consumer queue with a sequence counter per slot: a producer
+// claims a slot with one compare and swap, so there is no mutex and a Timer or an interrupt in the
+// middle of a post cannot corrupt it. The slot number is the command's sequence
+// number - loop() takes commands strictly in that order, so the last one posted is the one that sticks.
+class CommandMailbox {
+public:
+  static const size_t SIZE = 16;                                        // Power of two
+
+  enum Source : uint8_t { FUNCTION, SUBSCRIPTION, FAILSAFE, LOCAL };
+
+  struct Command {
+    uint32_t seq;                                                       // Order the commands were posted in
+    uint32_t postedAt;                                                  // millis()
+    uint8_t source;
+    uint8_t value;
+  };
+
+  CommandMailbox();
+
+  // Any context, including a Timer or an ISR - returns false if the mailbox is full, in which case the command is not taken
+  bool post(Source source, uint8_t value);
+
+  // loop() only - the oldest command not yet taken
+  bool take(Command &command);
+
+  uint32_t rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+
+  static const char *sourceName(uint8_t source);
+
+protected:
+  struct Slot {
+    std::atomic<uint32_t> sequence;                                     // Slot index when free, index + 1 when it holds a command
+    Command command;
+  };
+
+  Slot slots[SIZE];
+  std::atomic<uint32_t> postPos{0};
+  uint32_t takePos = 0;                                                 // loop() only
+  std::atomic<uint32_t> rejectedCount{0};
+};
+
+#endif /* __COMMANDMAILBOX_H */
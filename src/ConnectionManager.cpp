@@ -0,0 +1,171 @@
+#include "ConnectionManager.h"
+
+void ConnectionManager::Histogram::add(unsigned long ms) {
+  size_t bucket = 0;
+  for (unsigned long seconds = ms / 1000; seconds && bucket < BUCKETS - 1; seconds >>= 1) bucket++;
+  if (counts[bucket] != 0xffff) counts[bucket]++;
+}
+
+uint16_t ConnectionManager::Stats::checksum() const {
+  uint16_t sum = 0x5a5a;
+  for (size_t phase = 0; phase < PHASES; phase++) {
+    for (size_t i = 0; i < Histogram::BUCKETS; i++) sum = (uint16_t)(((sum << 3) | (sum >> 13)) ^ phases[phase].counts[i]);
+    sum = (uint16_t)(((sum << 3) | (sum >> 13)) ^ phases[phase].timeouts);
+  }
+  return sum;
+}
+
+void ConnectionManager::connect() {
+  wanted = true;                                                        // loop() starts the attempt
+}
+
+void ConnectionManager::disconnect() {
+  wanted = false;
+  if (state == OFF || state == DISCONNECTING || state == MODEM_OFF) return;
+  if (state == BACKOFF) {                                               // The modem is already off
+    enter(OFF);
+    return;
+  }
+  Particle.disconnect();
+  enter(DISCONNECTING);
+}
+
+bool ConnectionManager::loop() {
+  unsigned long inState = millis() - enteredAt;
+  switch (state) {
+  case OFF:
+    if (wanted) {
+      attemptStart = millis();
+      Cellular.on();
+      enter(MODEM_ON);
+    }
+    return false;
+
+  case MODEM_ON:
+    if (Cellular.isOn()) {
+      finishPhase(MODEM);
+      Cellular.connect();
+      enter(CELLULAR_WAIT);
+    }
+    else if (inState >= MODEM_ON_TIMEOUT_MS) {
+      fail(MODEM);
+      return true;
+    }
+    return false;
+
+  case CELLULAR_WAIT:
+    if (Cellular.ready()) {
+      finishPhase(CELLULAR);
+      Particle.connect();
+      enter(CLOUD_WAIT);
+    }
+    else if (inState >= CELLULAR_TIMEOUT_MS) {
+      fail(CELLULAR);
+      return true;
+    }
+    return false;
+
+  case CLOUD_WAIT:
+    if (Particle.connected()) {
+      finishPhase(CLOUD);
+      attemptMs = millis() - attemptStart;
+      failedAttempts = 0;
+      enter(CONNECTED);
+      Log.info("Connected in %lu ms", attemptMs);
+      return true;
+    }
+    else if (inState >= CLOUD_TIMEOUT_MS) {
+      fail(CLOUD);
+      return true;
+    }
+    return false;
+
+  case CONNECTED:
+    if (!Particle.connected()) {                                        // Lost - the system thread is already reconnecting, so time it as an attempt
+      attemptStart = millis();
+      enter(Cellular.ready() ? CLOUD_WAIT : CELLULAR_WAIT);
+      Log.info("Connection lost");
+    }
+    return false;
+
+  case BACKOFF:
+    if (inState >= backoffMs) enter(OFF);                               // The next pass starts an attempt if still wanted
+    return false;
+
+  case DISCONNECTING:
+    if (!Particle.connected() || inState >= DISCONNECT_TIMEOUT_MS) {
+      Cellular.disconnect();                                            // Detach from the network before the power goes
+      enter(MODEM_OFF);
+    }
+    return false;
+
+  case MODEM_OFF:
+    if (inState >= MODEM_DETACH_MS) {
+      Cellular.off();
+      enter(OFF);
+    }
+    return false;
+  }
+  return false;
+}
+
+size_t ConnectionManager::format(char *buf, size_t size) const {
+  static const char *names[PHASES] = {"modem", "cell", "cloud"};
+  size_t used = 0;
+  for (size_t phase = 0; phase < PHASES && used < size; phase++) {
+    const Histogram &h = totals.phases[phase];
+    int n = snprintf(buf + used, size - used, "%s%s %u,%u,%u,%u,%u,%u,%u,%u/%u", phase ? " " : "", names[phase],
+                     h.counts[0], h.counts[1], h.counts[2], h.counts[3], h.counts[4], h.counts[5], h.counts[6], h.counts[7], h.timeouts);
+    if (n < 0) break;
+    used += (size_t)n;
+  }
+  return (used < size) ? used : (size ? size - 1 : 0);
+}
+
+bool ConnectionManager::restoreStats(const Stats &saved) {
+  if (!saved.intact()) return false;
+  totals = saved;
+  return true;
+}
+
+void ConnectionManager::clearStats() {
+  totals = Stats();
+}
+
+const char *ConnectionManager::stateName(State state) {
+  switch (state) {
+  case OFF: return "Off";
+  case MODEM_ON: return "Modem On";
+  case CELLULAR_WAIT: return "Cellular Wait";
+  case CLOUD_WAIT: return "Cloud Wait";
+  case CONNECTED: return "Connected";
+  case BACKOFF: return "Backoff";
+  case DISCONNECTING: return "Disconnecting";
+  case MODEM_OFF: return "Modem Off";
+  }
+  return "Unknown";
+}
+
+void ConnectionManager::enter(State next) {
+  state = next;
+  enteredAt = millis();
+}
+
+void ConnectionManager::finishPhase(Phase phase) {
+  totals.phases[phase].add(millis() - enteredAt);
+}
+
+void ConnectionManager::fail(Phase phase) {
+  if (totals.phases[phase].timeouts != 0xffff) totals.phases[phase].timeouts++;
+  if (failedAttempts != 0xffff) failedAttempts++;
+  attemptMs = millis() - attemptStart;
+  Particle.disconnect();
+  Cellular.off();                                                       // Power cycles the modem - the next attempt starts clean
+
+  unsigned long base = BACKOFF_MIN_MS;
+  for (uint16_t i = 1; i < failedAttempts && base < BACKOFF_MAX_MS; i++) base *= 2;
+  if (base > BACKOFF_MAX_MS) base = BACKOFF_MAX_MS;
+  backoffMs = base - base / 4 + (unsigned long)random(base / 2 + 1);     // Sites that lost the same tower do not all come back at once
+  Log.info("Connection attempt failed at %s after %lu ms - retrying in %lu s", stateName(state), attemptMs, backoffMs / 1000);
+  enter(BACKOFF);
+}
@@ -0,0 +1,74 @@
+#ifndef __CONNECTIONMANAGER_H
+#define __CONNECTIONMANAGER_H
+
+#include "Particle.h"
+
+// Brings the modem and the cloud connection up and down without blocking loop()
+// Each attempt walks modem on, cellular registration and cloud session, timing every phase into a
+// histogram. A failed attempt turns the modem off and waits out an exponential backoff with jitter,
+// so a site without coverage is not hammering the network or the battery - or resetting to retry.
+class ConnectionManager {
+public:
+  enum State { OFF, MODEM_ON, CELLULAR_WAIT, CLOUD_WAIT, CONNECTED, BACKOFF, DISCONNECTING, MODEM_OFF };
+  enum Phase { MODEM, CELLULAR, CLOUD, PHASES };
+
+  static const unsigned long MODEM_ON_TIMEOUT_MS = 10000;
+  static const unsigned long CELLULAR_TIMEOUT_MS = 90000;               // What the blocking connect used to allow
+  static const unsigned long CLOUD_TIMEOUT_MS = 30000;
+  static const unsigned long BACKOFF_MIN_MS = 15000;                    // Doubles with each failed attempt - plus or minus a quarter
+  static const unsigned long BACKOFF_MAX_MS = 300000;
+  static const unsigned long DISCONNECT_TIMEOUT_MS = 10000;
+  static const unsigned long MODEM_DETACH_MS = 3000;                    // Between Cellular.disconnect() and Cellular.off()
+
+  // Phase times in powers of two seconds - bucket 0 is under a second, the last is 64 seconds and over
+  struct Histogram {
+    static const size_t BUCKETS = 8;
+    uint16_t counts[BUCKETS];
+    uint16_t timeouts;
+    void add(unsigned long ms);
+  };
+
+  struct Stats {                                                        // Plain data so it can be kept in FRAM across resets
+    Histogram phases[PHASES];
+    uint16_t check;
+    bool intact() const { return check == checksum(); }                 // Not torn and not whatever was in FRAM before
+    void seal() { check = checksum(); }                                 // Call before writing to FRAM
+    uint16_t checksum() const;
+  };
+
+  void connect();                                                       // Wanted up - starts an attempt unless one is running or backing off
+  void disconnect();                                                    // Wanted down - for sleep. Done once off() is true
+
+  // Call on every pass - returns true when an attempt has just connected or failed
+  bool loop();
+
+  State getState() const { return state; }
+  bool connected() const { return state == CONNECTED; }
+  bool off() const { return state == OFF; }
+  uint16_t failures() const { return failedAttempts; }                  // In a row - zeroed by a connection
+  unsigned long lastAttemptMs() const { return attemptMs; }             // Start to connected, or to the failure
+
+  const Histogram &histogram(Phase phase) const { return totals.phases[phase]; }
+  const Stats &stats() const { return totals; }
+  bool restoreStats(const Stats &saved);                                // Picks up the counts from before a reset - false if saved is not intact
+  size_t format(char *buf, size_t size) const;                          // "modem 3,0,0,0,0,0,0,0/0 cell ... cloud ..." - bucket counts / timeouts
+  void clearStats();
+
+  static const char *stateName(State state);
+
+protected:
+  void enter(State next);
+  void finishPhase(Phase phase);
+  void fail(Phase phase);
+
+  State state = OFF;
+  bool wanted = false;
+  unsigned long enteredAt = 0;                                          // millis() the current state started
+  unsigned long attemptStart = 0;
+  unsigned long attemptMs = 0;
+  unsigned long backoffMs = 0;
+  uint16_t failedAttempts = 0;
+  Stats totals = {};
+};
+
+#endif /* __CONNECTIONMANAGER_H */
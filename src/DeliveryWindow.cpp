@@ -0,0 +1,82 @@
+#include "DeliveryWindow.h"
+
+void DeliveryWindow::sent(uint32_t first, uint32_t last, uint16_t reports) {
+  int index = find(first);
+  if (index >= 0 && entries[index].first == first && entries[index].last == last) {  // Sent again - the clock starts over
+    entries[index].sentAt = millis();
+    return;
+  }
+  if (full()) remove(0);                                                // Callers check full() first - the oldest times out anyway
+  entries[count++] = {first, last, reports, millis(), false};
+}
+
+bool DeliveryWindow::ack(uint32_t seq) {
+  int index = find(seq);
+  if (index < 0 || entries[index].first != seq) return false;           // A batch is answered by its first seq
+  entries[index].acked = true;
+  return true;
+}
+
+bool DeliveryWindow::ackOldest() {
+  for (size_t i = 0; i < count; i++) {
+    if (!entries[i].acked) {
+      entries[i].acked = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+void DeliveryWindow::cancel(uint32_t first) {
+  int index = find(first);
+  if (index >= 0 && entries[index].first == first && !entries[index].acked) remove(index);
+}
+
+bool DeliveryWindow::acked(uint32_t seq) const {
+  int index = find(seq);
+  return index >= 0 && entries[index].acked;
+}
+
+void DeliveryWindow::forget(uint32_t seq) {
+  int index = find(seq);
+  if (index < 0) return;
+  Entry &entry = entries[index];
+  if (entry.last == seq || entry.reports <= 1) remove(index);
+  else {
+    entry.first = seq + 1;                                              // The rest of the batch is still in the queue
+    entry.reports--;
+  }
+}
+
+void DeliveryWindow::forgetBefore(uint32_t seq) {
+  size_t i = 0;
+  while (i < count) {
+    if ((int32_t)(entries[i].last - seq) < 0) remove(i);                // Wrap safe
+    else i++;
+  }
+}
+
+size_t DeliveryWindow::reports() const {
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) total += entries[i].reports;
+  return total;
+}
+
+bool DeliveryWindow::timedOut(unsigned long timeoutMs) const {
+  for (size_t i = 0; i < count; i++) {
+    if (!entries[i].acked && millis() - entries[i].sentAt >= timeoutMs) return true;
+  }
+  return false;
+}
+
+int DeliveryWindow::find(uint32_t seq) const {
+  for (size_t i = 0; i < count; i++) {
+    if (seq - entries[i].first <= entries[i].last - entries[i].first) return (int)i;  // Wrap safe
+  }
+  return -1;
+}
+
+void DeliveryWindow::remove(size_t index) {
+  for (size_t i = index + 1; i < count; i++) entries[i - 1] = entries[i];
+  count--;
+}
@@ -0,0 +1,50 @@
+#ifndef __DELIVERYWINDOW_H
+#define __DELIVERYWINDOW_H
+
+#include "Particle.h"
+
+// The reports that have been published but not yet acknowledged by the webhook, by sequence number
+// Several can be outstanding at once, so a backlog goes out back to back instead of one per round
+// trip. Acks may come back in any order - a report only leaves the FRAM queue once it and every
+// report before it are acknowledged. An ack for a sequence number not in the window (a late
+// response from before a reset, or a duplicate) is ignored instead of clearing the wrong report.
+// A batch is one entry covering a run of sequence numbers - acknowledged together by its first.
+class DeliveryWindow {
+public:
+  static const size_t SIZE = 4;                                         // The publish burst allowance
+
+  void sent(uint32_t seq) { sent(seq, seq, 1); }                        // Call as each report is published - in queue order
+  void sent(uint32_t first, uint32_t last, uint16_t reports);           // A batch - reports can be fewer than the run if a seq was skipped
+  bool ack(uint32_t seq);                                               // Returns false if seq is not the first of an entry in the window
+  bool ackOldest();                                                     // For a response without a sequence number
+  void cancel(uint32_t first);                                          // The publish never went out - the reports are sent again
+
+  bool contains(uint32_t seq) const { return find(seq) >= 0; }
+  bool acked(uint32_t seq) const;
+  void forget(uint32_t seq);                                            // Call once the report has left the FRAM queue - a batch entry goes with its last
+  void forgetBefore(uint32_t seq);                                      // Drops entries for reports the queue no longer holds
+  void clear() { count = 0; }
+
+  bool timedOut(unsigned long timeoutMs) const;                         // An unacknowledged report has waited this long
+  bool empty() const { return count == 0; }
+  bool full() const { return count == SIZE; }
+  size_t size() const { return count; }
+  size_t reports() const;                                               // In flight across all the entries
+
+protected:
+  struct Entry {
+    uint32_t first;                                                     // Moves up as the front of a batch leaves the queue
+    uint32_t last;
+    uint16_t reports;
+    unsigned long sentAt;                                               // millis()
+    bool acked;
+  };
+
+  int find(uint32_t seq) const;                                         // The entry whose run holds seq
+  void remove(size_t index);
+
+  Entry entries[SIZE];                                                  // Oldest first
+  size_t count = 0;
+};
+
+#endif /* __DELIVERYWINDOW_H */
@@ -0,0 +1,101 @@
+#include "EdgeCapture.h"
+
+EdgeCapture *EdgeCapture::instance = nullptr;
+
+int EdgeCapture::add(int pin, unsigned long debounceMs) {
+  if (channelCount == MAX_CHANNELS) return -1;
+  int channel = channelCount;
+  Channel &ch = channels[channel];
+  ch.pin = pin;
+  ch.debounceMicros = debounceMs * 1000;
+  ch.stable = ch.pending = pinReadFast(pin) ? HIGH : LOW;
+  ch.waiting = false;
+  ch.pendingSince = 0;
+  ch.heldMask = 1 << ch.stable;
+  if (ch.stable) lastLevels |= 1 << channel;                            // Set up before the interrupt can look at it
+  else lastLevels &= ~(1 << channel);
+  instance = this;
+  channelCount++;
+  attachInterrupt(pin, isr, CHANGE);
+  return channel;
+}
+
+void EdgeCapture::isr() {
+  if (instance) instance->capture();
+}
+
+void EdgeCapture::capture() {                                           // Interrupt context - no allocation, no logging, no waiting
+  uint32_t now = micros();
+  uint8_t levels = 0;
+  for (size_t i = 0; i < channelCount; i++) {                           // The interrupts share this handler, so see which input moved
+    if (pinReadFast(channels[i].pin)) levels |= 1 << i;
+  }
+  uint8_t changed = levels ^ lastLevels;
+  lastLevels = levels;
+
+  for (size_t i = 0; i < channelCount; i++) {
+    if (!(changed & (1 << i))) continue;
+    uint8_t h = head.load(std::memory_order_relaxed);
+    if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= RING_SIZE) {
+      overflowCount++;
+      overflowed.store(true, std::memory_order_release);
+      continue;
+    }
+    Edge &edge = ring[h % RING_SIZE];
+    edge.micros = now;
+    edge.channel = i;
+    edge.level = (levels >> i) & 1;
+    head.store(h + 1, std::memory_order_release);                       // Publishes the edge to loop()
+  }
+}
+
+bool EdgeCapture::loop() {
+  bool changed = false;
+  uint8_t t = tail.load(std::memory_order_relaxed);
+  uint8_t h = head.load(std::memory_order_acquire);
+  while (t != h) {
+    Edge edge = ring[t % RING_SIZE];                                    // Copied out before the slot is handed back
+    tail.store(++t, std::memory_order_release);
+    if (edge.channel < channelCount && accept(channels[edge.channel], edge.micros, edge.level)) changed = true;
+  }
+
+  if (overflowed.exchange(false, std::memory_order_acquire)) {          // Edges were lost - the ring no longer says where the inputs are
+    uint32_t now = micros();
+    for (size_t i = 0; i < channelCount; i++) {
+      if (accept(channels[i], now, pinReadFast(channels[i].pin) ? HIGH : LOW)) changed = true;
+    }
+  }
+
+  uint32_t now = micros();
+  for (size_t i = 0; i < channelCount; i++) {
+    if (settle(channels[i], now)) changed = true;
+  }
+  return changed;
+}
+
+bool EdgeCapture::held(int channel, int level) const {
+  return channels[channel].heldMask & (1 << (level ? HIGH : LOW));
+}
+
+void EdgeCapture::clearHeld() {
+  for (size_t i = 0; i < channelCount; i++) channels[i].heldMask = 1 << channels[i].stable;
+}
+
+bool EdgeCapture::accept(Channel &ch, uint32_t at, uint8_t level) {
+  bool changed = settle(ch, at);                                        // A level that outlasted the debounce before this edge counts, however late loop() got here
+  if (level == ch.stable) ch.waiting = false;                           // Bounced back before the debounce ran out
+  else if (!ch.waiting || level != ch.pending) {
+    ch.pending = level;
+    ch.pendingSince = at;
+    ch.waiting = true;
+  }
+  return changed;
+}
+
+bool EdgeCapture::settle(Channel &ch, uint32_t now) {
+  if (!ch.waiting || now - ch.pendingSince < ch.debounceMicros) return false;
+  ch.stable = ch.pending;
+  ch.waiting = false;
+  ch.heldMask |= 1 << ch.stable;
+  return true;
+}
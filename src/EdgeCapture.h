@@ -0,0 +1,64 @@
+#ifndef __EDGECAPTURE_H
+#define __EDGECAPTURE_H
+
+#include "Particle.h"
+#include <atomic>
+
+// Records every change on a few digital inputs from a pin interrupt, so a short power dip or a
+// level switch that opens and closes between two measurements is still seen.
+// The interrupt only timestamps the edge into a single producer / single consumer ring - loop()
+// drains it, debounces by timestamp and keeps a latch per input of every level it has held.
+// On the Electron each input must be on its own EXTI line (B1 and B3 share theirs with D1/A4 and D2/A0/A3).
+class EdgeCapture {
+public:
+  static const size_t MAX_CHANNELS = 4;
+  static const size_t RING_SIZE = 32;                                   // Power of two
+  static const unsigned long DEFAULT_DEBOUNCE_MS = 50;
+
+  struct Edge {
+    uint32_t micros;
+    uint8_t channel;
+    uint8_t level;
+  };
+
+  // Adds an input and attaches its interrupt - returns the channel number, -1 if there is no room
+  int add(int pin, unsigned long debounceMs = DEFAULT_DEBOUNCE_MS);
+
+  // Drains the ring and applies the debounce - returns true if any debounced level changed
+  bool loop();
+
+  int level(int channel) const { return channels[channel].stable; }     // Debounced
+  bool held(int channel, int level) const;                              // The debounced level was this at some point since clearHeld()
+  void clearHeld();                                                     // Call once the latches have been acted on
+
+  uint32_t overflows() const { return overflowCount; }                  // Edges lost because loop() fell behind - the levels are read again
+
+protected:
+  struct Channel {
+    int pin;
+    unsigned long debounceMicros;
+    uint8_t stable;                                                     // Debounced level
+    uint8_t pending;                                                    // Level waiting out the debounce
+    bool waiting;
+    uint32_t pendingSince;
+    uint8_t heldMask;                                                   // Bit 0 - was LOW, bit 1 - was HIGH
+  };
+
+  static void isr();
+  void capture();
+  bool accept(Channel &ch, uint32_t at, uint8_t level);
+  bool settle(Channel &ch, uint32_t now);
+
+  static EdgeCapture *instance;                                         // The pin interrupt has no context argument
+
+  Channel channels[MAX_CHANNELS];
+  size_t channelCount = 0;
+  volatile uint8_t lastLevels = 0;                                      // Only touched in the interrupt once begun
+  Edge ring[RING_SIZE];
+  std::atomic<uint8_t> head{0};                                         // Written by the interrupt only
+  std::atomic<uint8_t> tail{0};                                         // Written by loop() only
+  std::atomic<bool> overflowed{false};
+  volatile uint32_t overflowCount = 0;
+};
+
+#endif /* __EDGECAPTURE_H */
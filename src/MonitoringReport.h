@@ -0,0 +1,32 @@
+#ifndef __MONITORINGREPORT_H
+#define __MONITORINGREPORT_H
+
+#include <stdint.h>
+
+// A channel over the reporting window, in tenths - all zero if nothing was sampled
+struct WindowSummary {
+  int16_t min;
+  int16_t max;
+  int16_t mean;                                                         // Weighted by time - see RunningStats
+  int16_t stddev;
+};
+
+// One Monitoring_Event as it is queued in FRAM until the webhook confirms it
+// Fixed size and fixed width fields so the FRAM format does not depend on the compiler
+struct MonitoringReport {
+  uint32_t timestamp;                                                   // Unix time the report was taken - sent so late reports land in the right hour
+  uint32_t seq;                                                         // Numbers every report this device has taken - the webhook echoes it back
+  int16_t pumpAmps;
+  int16_t pumpMins;
+  int16_t temp;
+  int16_t resets;
+  uint8_t alertValue;
+  uint8_t battery;
+  uint8_t signal;                                                       // Mean signal strength over the reporting window, percent
+  uint8_t quality;                                                      // Mean signal quality over the reporting window, percent
+  WindowSummary ampsWindow;                                             // The fields above are the values when the report was taken
+  WindowSummary tempWindow;
+  WindowSummary batteryWindow;
+};
+
+#endif /* __MONITORINGREPORT_H */
@@ -0,0 +1,83 @@
+#include "PublishQueue.h"
+
+PublishQueue::PublishQueue() : tokens(BURST * TOKEN_MS) {
+}
+
+bool PublishQueue::publish(const char *name, const char *data, Priority priority, bool coalesce, uint32_t tag) {
+  if (coalesce) {
+    for (size_t i = 0; i < count; i++) {
+      if (strcmp(entries[i].name, name) == 0) {
+        strncpy(entries[i].data, data, DATA_SIZE - 1);                  // Keeps its place in the queue with the newest data
+        entries[i].data[DATA_SIZE - 1] = 0;
+        if (priority < entries[i].priority) entries[i].priority = priority;
+        entries[i].tag = tag;
+        return true;
+      }
+    }
+  }
+
+  size_t slot = count;
+  if (count == CAPACITY) {
+    size_t victim = CAPACITY;                                           // Newest message of the lowest priority that is below this one
+    for (size_t i = 0; i < count; i++) {
+      if (entries[i].priority <= priority) continue;
+      if (victim == CAPACITY || entries[i].priority > entries[victim].priority ||
+         (entries[i].priority == entries[victim].priority && (int32_t)(entries[i].sequence - entries[victim].sequence) > 0)) victim = i;
+    }
+    dropped++;
+    if (victim == CAPACITY) return false;                               // Everything waiting is at least as important
+    if (dropHandler) dropHandler(entries[victim].name, entries[victim].tag);  // It was accepted - the caller may be counting on it
+    slot = victim;
+  }
+  else count++;
+
+  Entry &entry = entries[slot];
+  entry.sequence = nextSequence++;
+  entry.priority = priority;
+  entry.tag = tag;
+  strncpy(entry.name, name, NAME_SIZE - 1);
+  entry.name[NAME_SIZE - 1] = 0;
+  strncpy(entry.data, data, DATA_SIZE - 1);
+  entry.data[DATA_SIZE - 1] = 0;
+  return true;
+}
+
+bool PublishQueue::accepts(Priority priority) const {
+  if (count < CAPACITY) return true;
+  for (size_t i = 0; i < count; i++) {
+    if (entries[i].priority > priority) return true;                    // Would be dropped to make room
+  }
+  return false;
+}
+
+void PublishQueue::refill() {
+  unsigned long now = millis();
+  tokens += now - lastRefill;
+  if (tokens > BURST * TOKEN_MS) tokens = BURST * TOKEN_MS;
+  lastRefill = now;
+}
+
+void PublishQueue::loop() {
+  refill();
+  if (count == 0 || tokens < TOKEN_MS || !Particle.connected()) return;
+
+  size_t next = 0;                                                      // Highest priority, then oldest
+  for (size_t i = 1; i < count; i++) {
+    if (entries[i].priority < entries[next].priority ||
+       (entries[i].priority == entries[next].priority && (int32_t)(entries[i].sequence - entries[next].sequence) < 0)) next = i;
+  }
+
+  Particle.publish(entries[next].name, entries[next].data, PRIVATE);
+  tokens -= TOKEN_MS;
+
+  entries[next] = entries[--count];                                     // Order is by sequence so the slot does not matter
+}
+
+void PublishQueue::flush(unsigned long timeoutMs) {
+  unsigned long startTime = millis();
+  while (count && millis() - startTime < timeoutMs) {
+    loop();
+    Particle.process();
+    delay(50);
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef __PUBLISHQUEUE_H
+#define __PUBLISHQUEUE_H
+
+#include "Particle.h"
+
+// Fixed-capacity queue of Particle.publish calls drained from loop() at the cloud rate limit
+// Callers never wait - the highest priority message goes out whenever the token bucket allows
+class PublishQueue {
+public:
+  enum Priority {                                                       // Lower value is sent first
+    CONTROL_ACK = 0,                                                    // Responses to pump control and configuration commands
+    ALERT,                                                              // Alerts, hook failures and error state actions
+    TELEMETRY,                                                          // Monitoring_Event reports
+    VERBOSE                                                             // State transitions and other diagnostics
+  };
+
+  static const size_t CAPACITY = 8;
+  static const size_t NAME_SIZE = 32;
+  static const size_t DATA_SIZE = 623;                                  // Particle.publish() takes 622 characters - a batch of reports uses them all
+  static const unsigned long TOKEN_MS = 1000;                           // Particle allows an average of one publish a second
+  static const unsigned long BURST = 4;                                 // and bursts of up to four
+
+  typedef void (*DropHandler)(const char *name, uint32_t tag);          // A message publish() accepted was later dropped for a more important one
+
+  PublishQueue();
+
+  // Adds a publish to the queue - returns false if it was dropped
+  // coalesce - replace the data of a waiting message with the same name instead of adding another
+  // When full, the newest message of the lowest priority below this one is dropped to make room
+  // tag - handed back to the drop handler if this message is the one dropped
+  bool publish(const char *name, const char *data, Priority priority, bool coalesce = false, uint32_t tag = 0);
+  bool accepts(Priority priority) const;                                // False if publish() would refuse a message of this priority now
+  void onDrop(DropHandler handler) { dropHandler = handler; }
+
+  // Sends at most one message if a token is available and the cloud is connected - call every pass through loop()
+  void loop();
+
+  // Blocks for up to timeoutMs to send everything that is waiting - only for use right before a reset
+  void flush(unsigned long timeoutMs);
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+  unsigned long getDropped() const { return dropped; }                  // Messages dropped since startup
+
+protected:
+  struct Entry {
+    uint32_t sequence;                                                  // Keeps messages of the same priority in order
+    uint8_t priority;
+    uint32_t tag;
+    char name[NAME_SIZE];
+    char data[DATA_SIZE];
+  };
+
+  void refill();
+
+  Entry entries[CAPACITY];
+  size_t count = 0;
+  uint32_t nextSequence = 0;
+  unsigned long tokens;                                                 // In milliseconds of rate, TOKEN_MS per publish
+  unsigned long lastRefill = 0;
+  unsigned long dropped = 0;
+  DropHandler dropHandler = nullptr;
+};
+
+#endif /* __PUBLISHQUEUE_H */
@@ -0,0 +1,33 @@
+#ifndef __PUMPFAILSAFE_H
+#define __PUMPFAILSAFE_H
+
+#include "Particle.h"
+
+// Limits how long the pump can run on one call
+// The run is timed on millis(), which a cloud time sync or an RTC correction cannot move, so the limit is
+// the same 95 minutes whatever happens to the clock - the Timer this replaced was monotonic too.
+// Unix time is only used across a reset: the pumping start kept in FRAM says how much of the budget is
+// left, and the resumed run is armed with that - a reset can neither extend a run nor cut the guarantee short.
+class PumpFailsafe {
+public:
+  static const uint32_t MAX_RUN_SECONDS = 95 * 60;                      // 95 minutes at Vinny's Request - email 3/3/21
+
+  void arm(uint32_t budgetSeconds = MAX_RUN_SECONDS) { armedAt = millis(); budgetMs = budgetSeconds * 1000UL; isArmed = true; }
+  void disarm() { isArmed = false; }
+  bool armed() const { return isArmed; }
+
+  bool expired() const { return isArmed && millis() - armedAt >= budgetMs; }
+  long remaining() const { return expired() || !isArmed ? 0 : (long)((budgetMs - (millis() - armedAt)) / 1000); }  // Seconds
+
+  // What is left of the budget of a run that started at startedAt - for picking a run back up after a reset, 0 if none
+  static uint32_t budgetLeft(time_t startedAt, time_t now) {
+    return (now >= startedAt && now < startedAt + (time_t)MAX_RUN_SECONDS) ? (uint32_t)(startedAt + MAX_RUN_SECONDS - now) : 0;
+  }
+
+protected:
+  unsigned long armedAt = 0;                                            // millis()
+  unsigned long budgetMs = 0;
+  bool isArmed = false;
+};
+
+#endif /* __PUMPFAILSAFE_H */
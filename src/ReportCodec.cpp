@@ -0,0 +1,268 @@
+#include "ReportCodec.h"
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+uint8_t *ReportCodec::putVarint(uint8_t *p, const uint8_t *end, uint32_t value) {
+  while (p && p < end) {
+    if (value < 0x80) {
+      *p++ = (uint8_t)value;
+      return p;
+    }
+    *p++ = (uint8_t)(value | 0x80);                                     // More to come
+    value >>= 7;
+  }
+  return nullptr;
+}
+
+const uint8_t *ReportCodec::getVarint(const uint8_t *p, const uint8_t *end, uint32_t &value) {
+  value = 0;
+  for (unsigned shift = 0; p && p < end && shift < 35; shift += 7) {
+    uint8_t byte = *p++;
+    if (shift == 28 && byte > 0x0f) return nullptr;                     // Would not fit in 32 bits
+    value |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return p;
+  }
+  return nullptr;                                                       // Ran off the end
+}
+
+void ReportCodec::fieldValues(const MonitoringReport &report, uint32_t fields[FIELDS]) {
+  fields[0] = report.alertValue;
+  fields[1] = zigzag(report.pumpAmps);
+  fields[2] = zigzag(report.pumpMins);
+  fields[3] = report.battery;
+  fields[4] = zigzag(report.temp);
+  fields[5] = zigzag(report.resets);
+  fields[6] = report.signal;
+  fields[7] = report.quality;
+  const WindowSummary *windows[] = {&report.ampsWindow, &report.tempWindow, &report.batteryWindow};
+  for (size_t i = 0; i < 3; i++) {
+    fields[8 + 4 * i] = zigzag(windows[i]->min);
+    fields[9 + 4 * i] = zigzag(windows[i]->max);
+    fields[10 + 4 * i] = zigzag(windows[i]->mean);
+    fields[11 + 4 * i] = zigzag(windows[i]->stddev);
+  }
+}
+
+bool ReportCodec::fieldsInRange(const uint32_t fields[FIELDS]) {
+  if ((fields[0] | fields[3] | fields[6] | fields[7]) > 0xff) return false;  // The uint8_t fields
+  uint32_t wide = fields[1] | fields[2] | fields[4] | fields[5];
+  for (size_t i = 8; i < FIELDS; i++) wide |= fields[i];
+  return wide <= 0xffff;                                                // The zigzagged int16_t fields
+}
+
+void ReportCodec::setFields(MonitoringReport &report, const uint32_t fields[FIELDS]) {
+  report.alertValue = (uint8_t)fields[0];
+  report.pumpAmps = (int16_t)unzigzag(fields[1]);
+  report.pumpMins = (int16_t)unzigzag(fields[2]);
+  report.battery = (uint8_t)fields[3];
+  report.temp = (int16_t)unzigzag(fields[4]);
+  report.resets = (int16_t)unzigzag(fields[5]);
+  report.signal = (uint8_t)fields[6];
+  report.quality = (uint8_t)fields[7];
+  WindowSummary *windows[] = {&report.ampsWindow, &report.tempWindow, &report.batteryWindow};
+  for (size_t i = 0; i < 3; i++) {
+    windows[i]->min = (int16_t)unzigzag(fields[8 + 4 * i]);
+    windows[i]->max = (int16_t)unzigzag(fields[9 + 4 * i]);
+    windows[i]->mean = (int16_t)unzigzag(fields[10 + 4 * i]);
+    windows[i]->stddev = (int16_t)unzigzag(fields[11 + 4 * i]);
+  }
+}
+
+uint8_t *ReportCodec::putFields(uint8_t *p, const uint8_t *end, const MonitoringReport &report) {
+  uint32_t fields[FIELDS];
+  fieldValues(report, fields);
+  for (size_t i = 0; i < FIELDS; i++) p = putVarint(p, end, fields[i]);
+  return p;
+}
+
+const uint8_t *ReportCodec::getFields(const uint8_t *p, const uint8_t *end, size_t count, MonitoringReport &report) {
+  uint32_t fields[FIELDS] = {};                                         // An older version leaves the windows zero
+  for (size_t i = 0; i < count; i++) p = getVarint(p, end, fields[i]);
+  if (!p || !fieldsInRange(fields)) return nullptr;
+  setFields(report, fields);
+  return p;
+}
+
+size_t ReportCodec::encode(const MonitoringReport &report, uint8_t *buf, size_t size) {
+  const uint8_t *end = buf + size;
+  uint8_t *p = putVarint(buf, end, VERSION);
+  p = putVarint(p, end, report.seq);
+  p = putVarint(p, end, report.timestamp);
+  p = putFields(p, end, report);
+  return p ? p - buf : 0;
+}
+
+size_t ReportCodec::decode(const uint8_t *buf, size_t len, MonitoringReport &report) {
+  const uint8_t *end = buf + len;
+  uint32_t version, seq, timestamp;
+  const uint8_t *p = getVarint(buf, end, version);
+  if (!p || layout(version) != VERSION) return 0;
+  p = getVarint(p, end, seq);
+  p = getVarint(p, end, timestamp);
+  MonitoringReport decoded;
+  p = getFields(p, end, fieldCount(version), decoded);
+  if (!p) return 0;
+  decoded.seq = seq;
+  decoded.timestamp = timestamp;
+  report = decoded;
+  return p - buf;
+}
+
+size_t ReportCodec::encodeDelta(const MonitoringReport &report, const MonitoringReport &base, uint8_t *buf, size_t size) {
+  uint32_t fields[FIELDS], baseFields[FIELDS];
+  fieldValues(report, fields);
+  fieldValues(base, baseFields);
+  uint32_t changed = 0;
+  for (size_t i = 0; i < FIELDS; i++) {
+    if (fields[i] != baseFields[i]) changed |= (uint32_t)1 << i;
+  }
+
+  const uint8_t *end = buf + size;
+  uint8_t *p = putVarint(buf, end, DELTA_VERSION);
+  p = putVarint(p, end, base.seq);
+  p = putVarint(p, end, report.seq - base.seq);
+  p = putVarint(p, end, zigzag32((int32_t)(report.timestamp - base.timestamp)));
+  p = putVarint(p, end, changed);
+  for (size_t i = 0; i < FIELDS; i++) {
+    if (changed & ((uint32_t)1 << i)) p = putVarint(p, end, fields[i]);
+  }
+  return p ? p - buf : 0;
+}
+
+size_t ReportCodec::encodeDeltaText(const MonitoringReport &report, const MonitoringReport &base, char *text, size_t size) {
+  uint8_t record[MAX_RECORD + 8];                                       // The base seq and the field bits on top of a full record
+  size_t len = encodeDelta(report, base, record, sizeof(record));
+  return armor(record, len, text, size);
+}
+
+bool ReportCodec::deltaBase(const uint8_t *buf, size_t len, uint32_t &baseSeq) {
+  if (!len || layout(buf[0]) != DELTA_VERSION) return false;
+  return getVarint(buf + 1, buf + len, baseSeq) != nullptr;
+}
+
+size_t ReportCodec::decodeDelta(const uint8_t *buf, size_t len, const MonitoringReport &base, MonitoringReport &report) {
+  const uint8_t *end = buf + len;
+  uint32_t version, baseSeq, seqDelta, timestampDelta, changed;
+  const uint8_t *p = getVarint(buf, end, version);
+  if (!p || layout(version) != DELTA_VERSION) return 0;
+  p = getVarint(p, end, baseSeq);
+  p = getVarint(p, end, seqDelta);
+  p = getVarint(p, end, timestampDelta);
+  if (!p || p == end || baseSeq != base.seq) return 0;
+  if (version == DELTA_VERSION) p = getVarint(p, end, changed);
+  else changed = *p++;                                                  // Version 3 - a plain byte for its eight fields
+  if (!p || changed >> fieldCount(version)) return 0;
+
+  uint32_t fields[FIELDS];
+  fieldValues(base, fields);
+  for (size_t i = 0; i < FIELDS; i++) {
+    if (changed & ((uint32_t)1 << i)) p = getVarint(p, end, fields[i]);
+  }
+  if (!p || !fieldsInRange(fields)) return 0;
+  setFields(report, fields);
+  report.seq = base.seq + seqDelta;
+  report.timestamp = base.timestamp + (uint32_t)unzigzag(timestampDelta);
+  return p - buf;
+}
+
+ReportCodec::Batch::Batch(uint8_t *buf, size_t size) : buf(buf), size(size), used(0) {
+  if (size >= 2) {
+    buf[0] = BATCH_VERSION;
+    buf[1] = 0;                                                         // The count - kept up to date by add()
+    used = 2;
+  }
+}
+
+bool ReportCodec::Batch::add(const MonitoringReport &report) {
+  if (!used || reports == MAX_BATCH) return false;
+  const uint8_t *end = buf + size;
+  uint8_t *p = putVarint(buf + used, end, report.seq - last.seq);       // The first is against zero - so the whole value
+  p = putVarint(p, end, zigzag32((int32_t)(report.timestamp - last.timestamp)));
+  p = putFields(p, end, report);
+  if (!p) return false;
+  used = p - buf;
+  buf[1] = (uint8_t)++reports;
+  last = report;
+  return true;
+}
+
+size_t ReportCodec::decodeBatch(const uint8_t *buf, size_t len, MonitoringReport *reports, size_t maxReports) {
+  if (!len || !maxReports) return 0;
+  if (layout(buf[0]) == VERSION) return decode(buf, len, reports[0]) == len ? 1 : 0;
+  if (layout(buf[0]) != BATCH_VERSION || len < 2) return 0;
+  size_t count = buf[1];
+  if (count == 0 || count > MAX_BATCH || count > maxReports) return 0;
+
+  const uint8_t *end = buf + len;
+  const uint8_t *p = buf + 2;
+  MonitoringReport last = {};
+  for (size_t i = 0; i < count; i++) {
+    uint32_t seqDelta, timestampDelta;
+    p = getVarint(p, end, seqDelta);
+    p = getVarint(p, end, timestampDelta);
+    p = getFields(p, end, fieldCount(buf[0]), reports[i]);
+    if (!p) return 0;
+    reports[i].seq = last.seq + seqDelta;
+    reports[i].timestamp = last.timestamp + (uint32_t)unzigzag(timestampDelta);
+    last = reports[i];
+  }
+  return p == end ? count : 0;                                          // Nothing left over
+}
+
+size_t ReportCodec::armor(const uint8_t *buf, size_t len, char *text, size_t size) {
+  size_t length = (len + 2) / 3 * 4;
+  if (length >= size) return 0;
+  char *out = text;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t group = (uint32_t)buf[i] << 16;
+    if (i + 1 < len) group |= (uint32_t)buf[i + 1] << 8;
+    if (i + 2 < len) group |= buf[i + 2];
+    *out++ = base64Alphabet[group >> 18];
+    *out++ = base64Alphabet[(group >> 12) & 0x3f];
+    *out++ = (i + 1 < len) ? base64Alphabet[(group >> 6) & 0x3f] : '=';
+    *out++ = (i + 2 < len) ? base64Alphabet[group & 0x3f] : '=';
+  }
+  *out = '\0';
+  return length;
+}
+
+size_t ReportCodec::unarmor(const char *text, uint8_t *buf, size_t size) {
+  size_t count = 0;
+  uint32_t group = 0;
+  unsigned bits = 0;
+  for (const char *c = text; *c && *c != '='; c++) {
+    int value;
+    if (*c >= 'A' && *c <= 'Z') value = *c - 'A';
+    else if (*c >= 'a' && *c <= 'z') value = *c - 'a' + 26;
+    else if (*c >= '0' && *c <= '9') value = *c - '0' + 52;
+    else if (*c == '+') value = 62;
+    else if (*c == '/') value = 63;
+    else return 0;
+    group = (group << 6) | value;
+    bits += 6;
+    if (bits >= 8) {
+      if (count == size) return 0;
+      bits -= 8;
+      buf[count++] = (uint8_t)(group >> bits);
+    }
+  }
+  return count;
+}
+
+size_t ReportCodec::encodeText(const MonitoringReport &report, char *text, size_t size) {
+  uint8_t record[MAX_RECORD];
+  size_t len = encode(report, record, sizeof(record));
+  return armor(record, len, text, size);
+}
+
+bool ReportCodec::decodeText(const char *text, MonitoringReport &report) {
+  uint8_t record[MAX_RECORD + 1];                                       // One over so a record with extra bytes fails the length check
+  size_t len = unarmor(text, record, sizeof(record));
+  return len && decode(record, len, report) == len;
+}
+
+size_t ReportCodec::decodeBatchText(const char *text, MonitoringReport *reports, size_t maxReports) {
+  uint8_t batch[Batch::maxLength(MAX_PUBLISH + 1)];                    // The most a publish can carry - anything longer fails to unarmor
+  size_t len = unarmor(text, batch, sizeof(batch));
+  return decodeBatch(batch, len, reports, maxReports);
+}
@@ -0,0 +1,91 @@
+#ifndef __REPORTCODEC_H
+#define __REPORTCODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MonitoringReport.h"
+
+// Packs a MonitoringReport into a few bytes for Monitoring_Event - the JSON it replaces was mostly key names
+// A record is a version byte then every field as a varint, seven bits a byte low first, signed ones zigzagged:
+//   version, seq, timestamp (seconds), alertValue, pumpAmps, pumpMins, battery, temp, resets, signal, quality,
+//   then min, max, mean and stddev of ampsWindow, tempWindow and batteryWindow
+// An hourly report packs to about 35 bytes, 48 characters of Base64 - the same report as JSON is about 330.
+// A backlog goes out as a batch instead: a version byte, the count, then the records without their
+// version byte and with seq and timestamp as the difference from the record before - about 27 bytes each.
+// A delta record names a base report the webhook already has and carries only the fields that differ from it:
+//   version, base seq, seq - base seq, timestamp - base timestamp (zigzagged), a varint with a bit per field, the changed fields
+// Versions 1 to 3 are the same three layouts before the window summaries - a byte for the delta bits. They
+// still decode, with the windows zero, so the webhook takes reports from devices not yet updated.
+// Nothing allocates and nothing formats - the device encodes, the webhook stand-in decodes with the same code.
+class ReportCodec {
+public:
+  static const uint8_t VERSION = 4;                                     // Bump for any change to the field list - decode() refuses the others
+  static const uint8_t BATCH_VERSION = 5;                               // The first byte tells a batch from a single record
+  static const size_t MAX_BATCH = 127;                                  // The count is a one byte varint
+  static const uint8_t DELTA_VERSION = 6;
+  static const size_t FIELDS = 20;                                      // After seq and timestamp
+  static const size_t FIELDS_V1 = 8;                                    // Versions 1 to 3
+  static const size_t MAX_RECORD = 1 + 2 * 5 + FIELDS * 3;              // Two 32 bit varints, the rest 16 bit or smaller
+  static const size_t MAX_TEXT = (MAX_RECORD + 2) / 3 * 4 + 1;          // Armored, with the terminator
+  static const size_t MAX_PUBLISH = 622;                                // Characters of data Particle.publish() takes - bounds a batch
+
+  // Returns the bytes written, 0 if size is too small
+  static size_t encode(const MonitoringReport &report, uint8_t *buf, size_t size);
+
+  // Returns the bytes read, 0 if the record is truncated, another version or a field does not fit
+  static size_t decode(const uint8_t *buf, size_t len, MonitoringReport &report);
+
+  // Base64 with padding, terminated - returns the length, 0 if size is too small
+  static size_t armor(const uint8_t *buf, size_t len, char *text, size_t size);
+
+  // Returns the bytes written, 0 on a character that is not Base64 or if size is too small
+  static size_t unarmor(const char *text, uint8_t *buf, size_t size);
+
+  static size_t encodeText(const MonitoringReport &report, char *text, size_t size);  // Both steps - what sendEvent() publishes
+  static bool decodeText(const char *text, MonitoringReport &report);   // False unless text is exactly one valid record
+
+  // A delta against base - returns the bytes written, 0 if size is too small
+  static size_t encodeDelta(const MonitoringReport &report, const MonitoringReport &base, uint8_t *buf, size_t size);
+  static size_t encodeDeltaText(const MonitoringReport &report, const MonitoringReport &base, char *text, size_t size);
+
+  // True if buf holds a delta record - baseSeq is the report the decoder has to look up and pass to decodeDelta()
+  static bool deltaBase(const uint8_t *buf, size_t len, uint32_t &baseSeq);
+  static size_t decodeDelta(const uint8_t *buf, size_t len, const MonitoringReport &base, MonitoringReport &report);  // Returns the bytes read, 0 if not valid
+
+  // Builds a batch in the caller's buffer one report at a time, in queue order
+  class Batch {
+  public:
+    Batch(uint8_t *buf, size_t size);
+    bool add(const MonitoringReport &report);                           // False if it does not fit - the batch is left as it was
+    size_t count() const { return reports; }
+    size_t length() const { return used; }
+    static constexpr size_t maxLength(size_t textSize) { return (textSize - 1) / 4 * 3; }  // The most bytes that armor into textSize with the terminator
+
+  protected:
+    uint8_t *buf;
+    size_t size;
+    size_t used;
+    size_t reports = 0;
+    MonitoringReport last = {};
+  };
+
+  // Either a batch or a single record - returns the number of reports, 0 if any of it is not valid
+  static size_t decodeBatch(const uint8_t *buf, size_t len, MonitoringReport *reports, size_t maxReports);
+  static size_t decodeBatchText(const char *text, MonitoringReport *reports, size_t maxReports);
+
+protected:
+  static uint8_t *putVarint(uint8_t *p, const uint8_t *end, uint32_t value);
+  static uint8_t *putFields(uint8_t *p, const uint8_t *end, const MonitoringReport &report);  // All but seq and timestamp
+  static const uint8_t *getFields(const uint8_t *p, const uint8_t *end, size_t count, MonitoringReport &report);
+  static bool fieldsInRange(const uint32_t fields[FIELDS]);
+  static void fieldValues(const MonitoringReport &report, uint32_t fields[FIELDS]);  // In record order, signed ones zigzagged
+  static void setFields(MonitoringReport &report, const uint32_t fields[FIELDS]);
+  static uint8_t layout(uint8_t version) { return (version >= 1 && version <= 3) ? version + 3 : version; }  // The current version with the same layout
+  static size_t fieldCount(uint8_t version) { return version <= 3 ? FIELDS_V1 : FIELDS; }
+  static const uint8_t *getVarint(const uint8_t *p, const uint8_t *end, uint32_t &value);
+  static uint32_t zigzag(int16_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 15); }
+  static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+  static uint32_t zigzag32(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+};
+
+#endif /* __REPORTCODEC_H */
@@ -0,0 +1,52 @@
+#include "ReportSchedule.h"
+
+namespace {
+  const long DAY = 86400;
+  const long DST_CHECK_AT = 2 * 3600;                                   // 2am local is when the US DST rules change the clock
+  const long DST_LATE_LIMIT = 3600;                                     // The DST check is only run in the hour it is due
+}
+
+void ReportSchedule::begin(int intervalMins, time_t savedCleanup) {
+  this->intervalMins = validInterval(intervalMins) ? intervalMins : DEFAULT_INTERVAL_MINS;
+  reportDeadline = dstDeadline = 0;                                     // Deadlines from before the clock was set are not due
+  cleanupDeadline = savedCleanup;                                       // A reset since midnight must not skip the day's cleanup
+  recompute();
+  reportDeadline = Time.now();                                          // The device has always reported once at startup
+}
+
+void ReportSchedule::setInterval(int intervalMins) {
+  if (!validInterval(intervalMins)) return;
+  this->intervalMins = intervalMins;
+  reportTaken();
+}
+
+void ReportSchedule::recompute() {
+  time_t now = Time.now();
+  long offset = (long)(Time.local() - now);
+  if (!due(reportDeadline, now)) reportDeadline = nextLocal(now, offset, intervalMins * 60L, 0);
+  if (!due(dstDeadline, now)) dstDeadline = nextLocal(now, offset, DAY, DST_CHECK_AT);
+  if (!due(cleanupDeadline, now)) cleanupDeadline = nextLocal(now, offset, DAY, 0);
+}
+
+void ReportSchedule::reportTaken() {
+  time_t now = Time.now();
+  reportDeadline = nextLocal(now, (long)(Time.local() - now), intervalMins * 60L, 0);
+}
+
+bool ReportSchedule::dstCheckTaken() {
+  time_t now = Time.now();
+  bool onTime = now - dstDeadline < DST_LATE_LIMIT;
+  dstDeadline = nextLocal(now, (long)(Time.local() - now), DAY, DST_CHECK_AT);
+  return onTime;
+}
+
+void ReportSchedule::cleanupTaken() {
+  time_t now = Time.now();
+  cleanupDeadline = nextLocal(now, (long)(Time.local() - now), DAY, 0);
+}
+
+time_t ReportSchedule::nextLocal(time_t now, long offset, long period, long at) {
+  time_t local = now + offset - at;
+  time_t next = (local / period + 1) * period;                          // Strictly after now so a deadline that was just reached moves on
+  return next + at - offset;
+}
@@ -0,0 +1,46 @@
+#ifndef __REPORTSCHEDULE_H
+#define __REPORTSCHEDULE_H
+
+#include "Particle.h"
+
+// Keeps the next report, DST check and daily cleanup times as Unix time deadlines
+// Calendar math is only done when a deadline is reached or the clock or time zone changes,
+// so checking whether anything is due is a single compare against Time.now()
+class ReportSchedule {
+public:
+  static const int DEFAULT_INTERVAL_MINS = 60;
+
+  // Report interval in minutes - 15, 30 or 60. Reports fall on local wall clock boundaries (:00, :15, ...).
+  static bool validInterval(int mins) { return mins == 15 || mins == 30 || mins == 60; }
+
+  // savedCleanup - nextCleanup() as saved before a reset. If it has passed, the cleanup is due now rather than tomorrow.
+  void begin(int intervalMins, time_t savedCleanup = 0);
+  void setInterval(int intervalMins);
+  int getInterval() const { return intervalMins; }
+
+  // Call after Time.zone(), beginDST(), endDST() or a time sync - the local offset or the clock changed
+  // A deadline that has already been reached is left as it is so the task still runs
+  void recompute();
+
+  time_t nextReport() const { return reportDeadline; }
+  time_t nextDSTCheck() const { return dstDeadline; }
+  time_t nextCleanup() const { return cleanupDeadline; }
+
+  void reportTaken();                                                   // Moves the report deadline to the next boundary after now
+
+  // Call once the DST check deadline has passed and the clock is valid - moves it to tomorrow
+  // Returns false if it was missed by more than an hour (a reset or clock jump) - the 2am change it makes is long past
+  bool dstCheckTaken();
+  void cleanupTaken();                                                  // However late - the day's counts still have to be zeroed
+
+protected:
+  static bool due(time_t deadline, time_t now) { return deadline != 0 && now >= deadline; }
+  static time_t nextLocal(time_t now, long offset, long period, long at);  // Next time after now that is at seconds past a multiple of period, local time
+
+  int intervalMins = DEFAULT_INTERVAL_MINS;
+  time_t reportDeadline = 0;
+  time_t dstDeadline = 0;
+  time_t cleanupDeadline = 0;
+};
+
+#endif /* __REPORTSCHEDULE_H */
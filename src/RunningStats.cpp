@@ -0,0 +1,43 @@
+#include "RunningStats.h"
+
+void RunningStats::add(int16_t value, uint32_t weight) {
+  if (!weight) return;
+  if (!samples || value < low) low = value;
+  if (!samples || value > high) high = value;
+  samples++;
+  totalWeight += weight;
+  sum += (int64_t)value * weight;
+  sumSquares += (int64_t)value * value * weight;
+}
+
+void RunningStats::clear() {
+  *this = RunningStats();
+}
+
+int16_t RunningStats::mean() const {
+  if (!samples) return 0;
+  int64_t half = totalWeight / 2;                                       // Rounds half away from zero
+  return (int16_t)((sum >= 0 ? sum + half : sum - half) / (int64_t)totalWeight);
+}
+
+uint32_t RunningStats::variance() const {
+  if (samples < 2) return 0;
+  int64_t weight = totalWeight;
+  int64_t spread = weight * sumSquares - sum * sum;                     // weight^2 x variance, exact
+  if (spread <= 0) return 0;
+  return (uint32_t)((spread + weight * weight / 2) / (weight * weight));
+}
+
+int16_t RunningStats::stddev() const {
+  uint32_t v = variance();
+  uint32_t root = 0;
+  for (uint32_t bit = 1UL << 30; bit; bit >>= 2) {                      // Integer square root, one bit a pass
+    if (v >= root + bit) {
+      v -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else root >>= 1;
+  }
+  if (v > root) root++;                                                 // v is now variance - root^2, so this rounds to nearest
+  return (int16_t)root;
+}
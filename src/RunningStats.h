@@ -0,0 +1,34 @@
+#ifndef __RUNNINGSTATS_H
+#define __RUNNINGSTATS_H
+
+#include "Particle.h"
+
+// Min, max, mean and standard deviation of a stream of samples in constant memory
+// Integer sums of value x weight and value squared x weight, like the fixed point calibration tables -
+// no soft float on the 1 second samples while pumping. The sums are exact, so the variance taken from
+// them at the end of the window has no rounding to cancel. Values are tenths and weights tenths of a second:
+// two hours of full scale samples still fit in the 64 bit sums. SamplePolicy measures every second while
+// pumping and every 30 when quiet, so each sample is weighted by the time it stands for - otherwise a
+// short pumping run would dominate the hour's mean.
+class RunningStats {
+public:
+  void add(int16_t value, uint32_t weight = 1);                         // A zero weight is ignored
+  void clear();
+
+  uint32_t count() const { return samples; }
+  int16_t min() const { return samples ? low : 0; }
+  int16_t max() const { return samples ? high : 0; }
+  int16_t mean() const;                                                 // Rounded to the nearest unit of the values
+  uint32_t variance() const;                                            // Of the window, not an estimate for a population - 0 for one sample
+  int16_t stddev() const;
+
+protected:
+  uint32_t samples = 0;
+  uint32_t totalWeight = 0;
+  int64_t sum = 0;                                                      // Of value x weight
+  int64_t sumSquares = 0;                                               // Of value x value x weight
+  int16_t low = 0;
+  int16_t high = 0;
+};
+
+#endif /* __RUNNINGSTATS_H */
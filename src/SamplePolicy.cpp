@@ -0,0 +1,21 @@
+#include "SamplePolicy.h"
+
+void SamplePolicy::inputs(uint8_t bits) {
+  if (bits == lastInputs) return;
+  lastInputs = bits;
+  trigger();
+}
+
+void SamplePolicy::trigger() {
+  activeAt = millis();
+  intervalMs = 0;
+}
+
+void SamplePolicy::sampled(bool active) {
+  sampledAt = millis();
+  if (active) activeAt = sampledAt;
+
+  if (sampledAt - activeAt < HOLD_MS) intervalMs = FAST_MS;
+  else if (intervalMs < IDLE_MS) intervalMs = IDLE_MS;
+  else intervalMs = (intervalMs * 2 < SLOW_MS) ? intervalMs * 2 : SLOW_MS;   // 2, 4, 8, 16, 30 seconds
+}
@@ -0,0 +1,36 @@
+#ifndef __SAMPLEPOLICY_H
+#define __SAMPLEPOLICY_H
+
+#include "Particle.h"
+
+// Decides when the next full measurement (ADC burst, fuel gauge, FRAM) is due
+// Fast while the pump runs or shortly after anything changed, then backs off to a slow idle
+// rate. The digital inputs are cheap to read, so they are watched on every pass and a change
+// makes the next measurement due right away.
+class SamplePolicy {
+public:
+  static const unsigned long FAST_MS = 1000;                            // Pumping or just after a change
+  static const unsigned long IDLE_MS = 2000;                            // First step of the back off - the old fixed rate
+  static const unsigned long SLOW_MS = 30000;                           // Quiet inputs for a while
+  static const unsigned long HOLD_MS = 60000;                           // Stays fast this long after the last activity
+
+  bool due() const { return millis() - sampledAt >= intervalMs; }
+
+  // Call on every pass with the current digital inputs packed into a byte - a change makes a measurement due now
+  void inputs(uint8_t bits);
+
+  void trigger();                                                       // Makes a measurement due now - for changes the input bits do not show
+
+  // Call after each measurement - active is true if the pump is running or the measurement found a change
+  void sampled(bool active);
+
+  unsigned long interval() const { return intervalMs; }
+
+protected:
+  uint8_t lastInputs = 0;
+  unsigned long sampledAt = 0;
+  unsigned long activeAt = 0;                                           // millis() of the last input change or active measurement
+  unsigned long intervalMs = 0;                                         // 0 - measure on the next pass
+};
+
+#endif /* __SAMPLEPOLICY_H */
@@ -0,0 +1,49 @@
+#include "SignalCache.h"
+
+bool SignalCache::loop() {
+  if (failedAt && millis() - failedAt < RETRY_MS) return false;
+  if (readAt && millis() - readAt < refreshMs) return false;
+  return refresh();
+}
+
+bool SignalCache::refreshIfOlderThan(unsigned long maxAgeMs) {
+  if (failedAt && millis() - failedAt < RETRY_MS) return false;
+  if (readAt && millis() - readAt < maxAgeMs) return false;
+  return refresh();
+}
+
+bool SignalCache::refresh() {
+  if (!Cellular.ready()) return false;
+  CellularSignal sig = Cellular.RSSI();                                 // The only modem round trip
+  float strength = sig.getStrength();
+  float quality = sig.getQuality();
+  if (strength < 0 || quality < 0) {                                    // The modem did not answer - wait before asking again
+    failedAt = millis();
+    if (!failedAt) failedAt = 1;
+    return false;
+  }
+  failedAt = 0;
+
+  rat = sig.getAccessTechnology();
+  lastStrength = (int)(strength + 0.5f);
+  lastQuality = (int)(quality + 0.5f);
+  add(strengthStats, lastStrength);
+  add(qualityStats, lastQuality);
+  readAt = millis();
+  if (!readAt) readAt = 1;                                              // 0 means no reading
+  return true;
+}
+
+void SignalCache::startWindow() {
+  strengthStats = {0, 0, 0, 0};
+  qualityStats = {0, 0, 0, 0};
+}
+
+void SignalCache::add(Window &window, int value) {
+  if (value > 255) value = 255;
+  if (!window.count || value < window.min) window.min = value;
+  if (!window.count || value > window.max) window.max = value;
+  if (window.count == 0xffff) return;                                   // The mean stays as it was
+  window.sum += value;
+  window.count++;
+}
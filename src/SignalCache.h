@@ -0,0 +1,53 @@
+#ifndef __SIGNALCACHE_H
+#define __SIGNALCACHE_H
+
+#include "Particle.h"
+
+// Cellular signal readings taken on their own slow cadence instead of on every sample
+// Cellular.RSSI() is a modem round trip, so everything else reads the last values from here.
+// Also keeps the min / mean / max over the current reporting window.
+class SignalCache {
+public:
+  static const unsigned long DEFAULT_REFRESH_MS = 300000;               // Five minutes
+  static const unsigned long RETRY_MS = 60000;                          // After the modem did not answer - not on every sample
+
+  struct Window {
+    uint16_t count;
+    uint8_t min;
+    uint8_t max;
+    uint32_t sum;
+    int mean() const { return count ? (int)((sum + count / 2) / count) : -1; }
+  };
+
+  SignalCache(unsigned long refreshMs = DEFAULT_REFRESH_MS) : refreshMs(refreshMs) {}
+
+  // Reads the signal if it is due and the modem is ready - returns true if there is a new reading
+  bool loop();
+
+  // Reads the signal now unless the last reading is younger than maxAgeMs - use before a report
+  bool refreshIfOlderThan(unsigned long maxAgeMs);
+
+  bool valid() const { return readAt != 0; }
+  int accessTechnology() const { return rat; }
+  int strength() const { return lastStrength; }                         // Percent, -1 before the first reading
+  int quality() const { return lastQuality; }                           // Percent, -1 before the first reading
+  const Window &strengthWindow() const { return strengthStats; }
+  const Window &qualityWindow() const { return qualityStats; }
+
+  void startWindow();                                                   // Clears the min / mean / max - call once a report has taken them
+
+protected:
+  bool refresh();
+  static void add(Window &window, int value);
+
+  unsigned long refreshMs;
+  unsigned long readAt = 0;                                             // millis() of the last good reading, 0 for none
+  unsigned long failedAt = 0;                                           // millis() of the last read the modem did not answer, 0 once one works
+  int rat = 0;
+  int lastStrength = -1;
+  int lastQuality = -1;
+  Window strengthStats = {0, 0, 0, 0};
+  Window qualityStats = {0, 0, 0, 0};
+};
+
+#endif /* __SIGNALCACHE_H */